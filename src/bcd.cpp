@@ -11,12 +11,22 @@
 ///\brief Implements some operations on arbitrary sized packed bcd numbers
 
 #include "bcd.hpp"
+#include "threadpool.hpp"
 #include <cstring>
 #include <cstdlib>
 #include <stdexcept>
 #include <limits>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <new>
+#ifdef BCD_STATISTICS
+#include <chrono>
+#include <mutex>
+#endif
+#ifdef BCD_USDT
+#include <sys/sdt.h>
+#endif
 
 #define NumMask 0x0fffFFFFffffFFFFULL
 #define NumHighShift 60
@@ -24,51 +34,409 @@
 #define MaxEstimate 100000000000000ULL
 
 #define long_DIGITS 20
+#define ProductLeafSize 16
+#define DefaultParallelThreshold 100000
+#define ParallelChunksPerThread 4
+#define ParallelMinSummands 4096
+#define ParallelMinFactors 64
+#define ElementBase 1000000000000000ULL
+#define SumCarryInterval 16384
+#define NinesMask 0x0999999999999999ULL
+#define NegativeBias 500000000000000ULL
+#define MaxVectorScalarFactor 10000
+#define BinomialSieveRatio 16
 
 using namespace bcd;
+using namespace bcd::literals;
+using namespace bcd::detail;
+
+__extension__ typedef unsigned __int128 DoubleElement;
+
+static std::uint64_t long_magnitude( long num) noexcept
+{
+	return num < 0 ? -(std::uint64_t)num : (std::uint64_t)num;
+}
+
+// ... input is validated when parsed, the results of the kernels only in checked builds (BCD_CHECKED) for debugging and fuzzing
+#ifdef BCD_CHECKED
+static constexpr bool CheckResults = true;
+#else
+static constexpr bool CheckResults = false;
+#endif
+
+// ... in reference mode the operations skip their fast paths (small operands, machine integer operands, parallelization) for cross checking them
+static std::atomic<bool> g_referenceMode( false);
+
+static bool reference_mode() noexcept
+{
+	return g_referenceMode.load( std::memory_order_relaxed);
+}
+
+#ifdef BCD_STATISTICS
+enum StatisticsOperation
+{
+	OpParse, OpToString, OpAdd, OpSub, OpMul, OpDiv, OpMod, OpNeg, OpPow, OpRoot,
+	OpFactorial, OpBinomial, OpProduct, OpSum, OpDot, OpCompare, OpShift, OpCut, OpRound,
+	OpBitAnd, OpBitOr, OpBitXor, OpBitNot,
+	NofStatisticsOperations
+};
+static const char* g_statisticsOperationNames[ NofStatisticsOperations] = {
+	"parse", "tostring", "add", "sub", "mul", "div", "mod", "neg", "pow", "iroot",
+	"factorial", "binomial", "product", "sum", "dot", "compare", "shift", "cut", "round",
+	"bit_and", "bit_or", "bit_xor", "bit_not"
+};
+
+// ... counters written only by the owning thread without locked instructions, read by any thread, never reset
+typedef std::atomic<std::uint64_t> StatisticsCounter;
+
+static void increment( StatisticsCounter& counter, std::uint64_t value) noexcept
+{
+	counter.store( counter.load( std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct OperationCounters
+{
+	StatisticsCounter count;
+	StatisticsCounter nanoseconds;
+	StatisticsCounter allocations;
+	StatisticsCounter allocatedBytes;
+	StatisticsCounter sizes[ BigInt::NofSizeClasses];
+};
+
+struct ThreadStatistics;
+static std::mutex g_statisticsMutex;
+static std::vector<ThreadStatistics*> g_statisticsThreads;
+// ... totals of the threads terminated
+static std::vector<BigInt::OperationStatistics> g_statisticsRetired( NofStatisticsOperations);
+// ... totals at the last reset, subtracted from the totals reported
+static std::vector<BigInt::OperationStatistics> g_statisticsBaseline( NofStatisticsOperations);
+
+static void add_statistics( std::vector<BigInt::OperationStatistics>& dest, const OperationCounters* counters) noexcept
+{
+	for (std::size_t oi = 0; oi < NofStatisticsOperations; ++oi)
+	{
+		dest[ oi].count += counters[ oi].count.load( std::memory_order_relaxed);
+		dest[ oi].nanoseconds += counters[ oi].nanoseconds.load( std::memory_order_relaxed);
+		dest[ oi].allocations += counters[ oi].allocations.load( std::memory_order_relaxed);
+		dest[ oi].allocatedBytes += counters[ oi].allocatedBytes.load( std::memory_order_relaxed);
+		for (std::size_t si = 0; si < BigInt::NofSizeClasses; ++si)
+		{
+			dest[ oi].sizes[ si] += counters[ oi].sizes[ si].load( std::memory_order_relaxed);
+		}
+	}
+}
+
+struct ThreadStatistics
+{
+	OperationCounters operations[ NofStatisticsOperations];
+	StatisticsCounter allocations;
+	StatisticsCounter allocatedBytes;
+
+	ThreadStatistics() noexcept
+	{
+		// ... the statistics of a thread that cannot be registered are not reported
+		std::lock_guard<std::mutex> lock( g_statisticsMutex);
+		try
+		{
+			g_statisticsThreads.push_back( this);
+		}
+		catch (...) {}
+	}
+	~ThreadStatistics()
+	{
+		std::lock_guard<std::mutex> lock( g_statisticsMutex);
+		auto ti = std::find( g_statisticsThreads.begin(), g_statisticsThreads.end(), this);
+		if (ti != g_statisticsThreads.end())
+		{
+			add_statistics( g_statisticsRetired, operations);
+			g_statisticsThreads.erase( ti);
+		}
+	}
+};
+
+static ThreadStatistics& thread_statistics() noexcept
+{
+	static thread_local ThreadStatistics rt;
+	return rt;
+}
+
+static unsigned int size_class( std::size_t size) noexcept
+{
+	unsigned int rt = 0;
+	for (; size && rt+1 < BigInt::NofSizeClasses; size >>= 1) ++rt;
+	return rt;
+}
+
+// ... measures the operation from construction to destruction, nested operations are included
+class StatisticsScope
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	StatisticsScope( StatisticsOperation op, std::size_t size) noexcept
+		:m_thread(thread_statistics()),m_op(op),m_sizeClass(size_class( size))
+		,m_allocations(m_thread.allocations.load( std::memory_order_relaxed))
+		,m_allocatedBytes(m_thread.allocatedBytes.load( std::memory_order_relaxed))
+		,m_start(Clock::now()){}
+	~StatisticsScope()
+	{
+		OperationCounters& counters = m_thread.operations[ m_op];
+		increment( counters.nanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - m_start).count());
+		increment( counters.count, 1);
+		increment( counters.allocations, m_thread.allocations.load( std::memory_order_relaxed) - m_allocations);
+		increment( counters.allocatedBytes, m_thread.allocatedBytes.load( std::memory_order_relaxed) - m_allocatedBytes);
+		increment( counters.sizes[ m_sizeClass], 1);
+	}
+
+private:
+	ThreadStatistics& m_thread;
+	StatisticsOperation m_op;
+	unsigned int m_sizeClass;
+	std::uint64_t m_allocations;
+	std::uint64_t m_allocatedBytes;
+	Clock::time_point m_start;
+};
+#define BCD_STATISTICS_SCOPE( op, size)	StatisticsScope statisticsScope( op, size)
+#else
+#define BCD_STATISTICS_SCOPE( op, size)
+#endif
+
+#ifdef BCD_USDT
+// ... fires the static tracepoints bcd:kernel_entry( name, elements of the operands) on construction and bcd:kernel_return( name, elements of the result) on destruction
+class KernelProbeScope
+{
+public:
+	KernelProbeScope( const char* name, const BigInt* result, std::size_t size1, std::size_t size2) noexcept
+		:m_name(name),m_result(result)
+	{
+		DTRACE_PROBE3( bcd, kernel_entry, name, size1, size2);
+	}
+	~KernelProbeScope()
+	{
+		std::size_t size = m_result ? m_result->nof_elements() : 0;
+		DTRACE_PROBE2( bcd, kernel_return, m_name, size);
+	}
+
+private:
+	const char* m_name;
+	const BigInt* m_result;
+};
+#define BCD_KERNEL_PROBE_SCOPE( name, result, size1, size2)	KernelProbeScope kernelProbeScope( name, result, size1, size2)
+#else
+#define BCD_KERNEL_PROBE_SCOPE( name, result, size1, size2)
+#endif
+
+#ifdef BCD_STATISTICS
+// ... the totals of all threads since the start of the program, the caller holds g_statisticsMutex
+static std::vector<BigInt::OperationStatistics> statistics_totals()
+{
+	std::vector<BigInt::OperationStatistics> rt = g_statisticsRetired;
+	for (ThreadStatistics* thread : g_statisticsThreads)
+	{
+		add_statistics( rt, thread->operations);
+	}
+	return rt;
+}
+#endif
+
+std::vector<BigInt::OperationStatistics> BigInt::statistics()
+{
+	std::vector<OperationStatistics> rt;
+#ifdef BCD_STATISTICS
+	std::lock_guard<std::mutex> lock( g_statisticsMutex);
+	rt = statistics_totals();
+	// ... the counters only grow, so the totals are never smaller than the baseline
+	for (std::size_t oi = 0; oi < NofStatisticsOperations; ++oi)
+	{
+		const OperationStatistics& base = g_statisticsBaseline[ oi];
+		rt[ oi].name = g_statisticsOperationNames[ oi];
+		rt[ oi].count -= base.count;
+		rt[ oi].nanoseconds -= base.nanoseconds;
+		rt[ oi].allocations -= base.allocations;
+		rt[ oi].allocatedBytes -= base.allocatedBytes;
+		for (std::size_t si = 0; si < NofSizeClasses; ++si)
+		{
+			rt[ oi].sizes[ si] -= base.sizes[ si];
+		}
+	}
+#endif
+	return rt;
+}
+
+void BigInt::resetStatistics()
+{
+#ifdef BCD_STATISTICS
+	// ... the counters of other threads are not written, their owners update them without locked instructions
+	std::lock_guard<std::mutex> lock( g_statisticsMutex);
+	g_statisticsBaseline = statistics_totals();
+#endif
+}
 
 void BigInt::swap( BigInt& o) noexcept
 {
 	std::swap( m_ar, o.m_ar);
 	std::swap( m_size, o.m_size);
+	std::swap( m_capacity, o.m_capacity);
 	std::swap( m_sign, o.m_sign);
 	std::swap( m_allocated, o.m_allocated);
+	std::swap( m_nofDigits, o.m_nofDigits);
 }
 
-void BigInt::allocate( std::size_t nn)
+static std::atomic<BigInt::AllocFunction> g_allocFunction( nullptr);
+static std::atomic<void*> g_allocContext( nullptr);
+static std::atomic<std::size_t> g_memoryInUse( 0);
+static std::atomic<std::size_t> g_memoryAllocated( 0);
+
+void BigInt::setAllocator( AllocFunction func, void* ctx) noexcept
 {
-	if (m_ar && m_allocated) free( m_ar);
-	m_size = nn;
-	if (m_size)
+	g_allocContext = ctx;
+	g_allocFunction = func;
+}
+
+std::size_t BigInt::memoryInUse() noexcept
+{
+	return g_memoryInUse;
+}
+
+std::size_t BigInt::memoryAllocated() noexcept
+{
+	return g_memoryAllocated;
+}
+
+static void* allocate_elements( std::size_t mm)
+{
+	BigInt::AllocFunction func = g_allocFunction;
+	void* rt = func ? func( g_allocContext, nullptr, 0, mm) : std::malloc( mm);
+	if (!rt) throw std::bad_alloc();
+#ifdef BCD_STATISTICS
+	ThreadStatistics& statistics = thread_statistics();
+	increment( statistics.allocations, 1);
+	increment( statistics.allocatedBytes, mm);
+#endif
+	g_memoryInUse.fetch_add( mm, std::memory_order_relaxed);
+	g_memoryAllocated.fetch_add( mm, std::memory_order_relaxed);
+	return rt;
+}
+
+static void free_elements( void* ptr, std::size_t mm) noexcept
+{
+	BigInt::AllocFunction func = g_allocFunction;
+	if (func)
 	{
-		std::size_t mm = nn * sizeof(*m_ar);
-		if (mm < nn) throw std::bad_alloc();
-		m_ar = (Element*)std::malloc( mm);
-		if (!m_ar) throw std::bad_alloc();
-		std::memset( m_ar, 0, mm);
-		m_allocated = true;
+		func( g_allocContext, ptr, mm, 0);
 	}
 	else
 	{
-		m_ar = nullptr;
-		m_allocated = false;
+		std::free( ptr);
+	}
+	g_memoryInUse.fetch_sub( mm, std::memory_order_relaxed);
+}
+
+// ... allocated elements are preceded by a reference counter, copies share them and nothing writes into shared elements
+struct SharedElementsHeader
+{
+	std::atomic<std::size_t> refcnt;
+	std::size_t padding;
+
+	SharedElementsHeader() noexcept :refcnt(1),padding(0){}
+};
+
+static SharedElementsHeader* shared_header( BigInt::Element* ar) noexcept
+{
+	return (SharedElementsHeader*)((char*)ar - sizeof(SharedElementsHeader));
+}
+
+bool BigInt::shared() const noexcept
+{
+	return m_allocated && shared_header( m_ar)->refcnt.load( std::memory_order_acquire) > 1;
+}
+
+void BigInt::share( const BigInt& o) noexcept
+{
+	shared_header( o.m_ar)->refcnt.fetch_add( 1, std::memory_order_relaxed);
+	release_elements();
+	m_size = o.m_size;
+	m_capacity = o.m_capacity;
+	m_ar = o.m_ar;
+	m_sign = o.m_sign;
+	m_allocated = true;
+	m_nofDigits = o.m_nofDigits;
+}
+
+void BigInt::release_elements() noexcept
+{
+	if (m_ar && m_allocated && shared_header( m_ar)->refcnt.fetch_sub( 1, std::memory_order_acq_rel) == 1)
+	{
+		SharedElementsHeader* header = shared_header( m_ar);
+		header->~SharedElementsHeader();
+		free_elements( header, sizeof(SharedElementsHeader) + m_capacity * sizeof(*m_ar));
+	}
+	init();
+}
+
+void BigInt::release() noexcept
+{
+	release_elements();
+}
+
+void BigInt::allocate( std::size_t nn)
+{
+	if (shared())
+	{
+		// ... the elements of copies are not overwritten, this number gets its own
+		release_elements();
+	}
+	if (nn <= m_capacity)
+	{
+		// ... reuse the elements, owned or attached storage
+		if (nn) std::memset( m_ar, 0, nn * sizeof(*m_ar));
+		m_size = nn;
+		m_sign = false;
+		m_nofDigits = 0;
+		return;
 	}
+	std::size_t mm = nn * sizeof(*m_ar);
+	if (mm < nn || mm + sizeof(SharedElementsHeader) < mm) throw std::bad_alloc();
+	void* block = allocate_elements( mm + sizeof(SharedElementsHeader));
+	Element* ar = (Element*)((char*)new (block) SharedElementsHeader() + sizeof(SharedElementsHeader));
+	release_elements();
+	m_ar = ar;
+	m_size = nn;
+	std::memset( m_ar, 0, mm);
+	m_allocated = true;
+	m_capacity = nn;
+	m_sign = false;
+	m_nofDigits = 0;
+}
+
+void BigInt::attach( Element* storage, std::size_t capacity) noexcept
+{
+	release_elements();
+	m_size = 0;
+	m_capacity = capacity;
+	m_ar = storage;
 	m_sign = false;
+	m_allocated = false;
+	m_nofDigits = 0;
 }
 
 BigInt::BigInt() noexcept
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {}
 
 void BigInt::init()
 {
 	m_size = 0;
+	m_capacity = 0;
 	m_ar = nullptr;
 	m_sign = false;
 	m_allocated = false;
+	m_nofDigits = 0;
 }
 
 BigNumber::~BigNumber()
@@ -218,8 +586,12 @@ BigNumber::BigNumber( const char* val, std::size_t valsize)
 	}
 	if (m_size == 0)
 	{
+		// ... realloc with size 0 may free the buffer
+		std::free( m_ar);
+		m_ar = nullptr;
 		m_scale = 0;
 		m_sign = 0;
+		return;
 	}
 	unsigned char* ar_ = (unsigned char*)std::realloc( m_ar, m_size);
 	if (ar_) m_ar = ar_;
@@ -289,35 +661,65 @@ void BigInt::init( const BigNumber& num)
 
 void BigInt::init( const std::string& str)
 {
-	BigNumber num( str.c_str(), str.size());
-	init( num);
+	init( str.c_str(), str.size());
 }
 
 void BigInt::init( const char* str, std::size_t strsize)
 {
+	BCD_STATISTICS_SCOPE( OpParse, strsize / NumDigits);
+	// ... integers without fraction or exponent are packed directly, without a buffer of the digits and without limit of the size
+	std::size_t start = (strsize && (str[0] == '-' || str[0] == '+')) ? 1 : 0;
+	std::size_t si = start;
+	for (; si < strsize && str[ si] >= '0' && str[ si] <= '9'; ++si){}
+	if (si == strsize && si > start)
+	{
+		init_digits( str + start, strsize - start, str[0] == '-');
+		return;
+	}
 	BigNumber num( str, strsize);
 	init( num);
 }
 
-void BigInt::init( long num)
+void BigInt::init_digits( const char* digits, std::size_t nofDigits, bool sign)
 {
-	init();
-	bool ng = false;
-	if (num < 0)
+	for (; nofDigits && *digits == '0'; ++digits,--nofDigits){}
+	if (!nofDigits)
 	{
-		ng = true;
-		num = -num;
+		allocate( 0);
+		return;
 	}
-	BigInt th = estimate_as_bcd( (FactorType)num, 0);
-	th.m_sign ^= ng;
-	copy( th);
+	// ... the digits are read in ascending order, the first element gets the digits not filling a whole element
+	std::size_t ei = (nofDigits + NumDigits - 1) / NumDigits;
+	std::size_t chunk = nofDigits - (ei-1) * NumDigits;
+	allocate( ei);
+	const char* de = digits + nofDigits;
+	while (digits != de)
+	{
+		Element elem = 0;
+		for (const char* ce = digits + chunk; digits != ce; ++digits)
+		{
+			elem = (elem << 4) | (Element)(*digits - '0');
+		}
+		m_ar[ --ei] = elem;
+		chunk = NumDigits;
+	}
+	m_sign = sign;
+	trim();
+}
+
+void BigInt::init( long num)
+{
+	init( (unsigned long)long_magnitude( num));
+	m_sign = (num < 0) && m_size;
 }
 
 void BigInt::init( unsigned long num)
 {
-	init();
-	BigInt th = estimate_as_bcd( (FactorType)num, 0);
-	copy( th);
+	// ... at most 20 digits, converted directly without division estimate
+	allocate( 2);
+	m_ar[ 0] = uint_to_bcd( num % ElementBase);
+	m_ar[ 1] = uint_to_bcd( num / ElementBase);
+	trim();
 }
 
 void BigInt::init( double num)
@@ -329,83 +731,215 @@ void BigInt::init( double num)
 
 BigInt::BigInt( const std::string& numstr)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	init( numstr);
 }
 
 BigInt::BigInt( const char* numstr, std::size_t numlen)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	init( numstr, numlen);
 }
 
 BigInt::BigInt( const BigNumber& num)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	BigInt::init( num);
 }
 
 BigInt::BigInt( long num)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	BigInt::init( num);
 }
 
 BigInt::BigInt( unsigned long num)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	BigInt::init( num);
 }
 
 BigInt::BigInt( double num)
 	:m_size(0)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(false)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
 	BigInt::init( num);
 }
 
 BigInt::BigInt( const BigInt& o)
 	:m_size(o.m_size)
+	,m_capacity(0)
 	,m_ar(0)
 	,m_sign(o.m_sign)
 	,m_allocated(false)
+	,m_nofDigits(0)
 {
+	if (o.m_allocated)
+	{
+		share( o);
+		return;
+	}
 	allocate( m_size);
 	m_sign = o.m_sign;
-	std::memcpy( m_ar, o.m_ar, m_size * sizeof(*m_ar));
+	m_nofDigits = o.m_nofDigits;
+	if (m_size) std::memcpy( m_ar, o.m_ar, m_size * sizeof(*m_ar));
 }
 
 void BigInt::copy( const BigInt& o)
 {
+	if (&o == this) return;
+	if (o.m_allocated && (m_allocated || m_capacity < o.m_size))
+	{
+		// ... allocated elements are shared, attached storage is filled if the number fits into it
+		share( o);
+		return;
+	}
 	allocate( o.m_size);
 	m_sign = o.m_sign;
-	std::memcpy( m_ar, o.m_ar, m_size * sizeof(*m_ar));
+	m_nofDigits = o.m_nofDigits;
+	if (m_size) std::memcpy( m_ar, o.m_ar, m_size * sizeof(*m_ar));
+}
+
+BigInt BigInt::constant( const Element* ar, std::size_t size, bool sign) noexcept
+{
+	return BigInt( const_cast<Element*>( ar), size, sign);
 }
 
 BigInt::~BigInt()
 {
-	if (m_ar && m_allocated) free( m_ar);
+	release_elements();
+}
+
+#define SerializeVersion 1
+#define SerializeHeaderSize 16
+#define SerializeFlagNegative 1
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static constexpr bool LittleEndian = true;
+#else
+static constexpr bool LittleEndian = false;
+#endif
+
+static void store_word( unsigned char* dest, std::uint64_t val) noexcept
+{
+	for (int ii = 0; ii < 8; ++ii, val >>= 8) dest[ ii] = (unsigned char)(val & 0xff);
+}
+
+static std::uint64_t load_word( const unsigned char* src) noexcept
+{
+	std::uint64_t rt = 0;
+	for (int ii = 0; ii < 8; ++ii) rt |= (std::uint64_t)src[ ii] << (ii * 8);
+	return rt;
+}
+
+// ... the operations expect valid digits and no leading zero elements
+static void check_serialized_elements( const BigInt::Element* ar, std::size_t size, bool sign)
+{
+	BigInt::Element chkval = 0;
+	for (std::size_t ii = 0; ii < size; ++ii)
+	{
+		chkval |= checkvalue( ar[ ii]) | (ar[ ii] & ~NumMask);
+	}
+	if (chkval || (size && !ar[ size-1]) || (sign && !size))
+	{
+		throw std::runtime_error( "corrupt serialized bcd number");
+	}
+}
+
+std::size_t BigInt::serialized_size() const noexcept
+{
+	return SerializeHeaderSize + m_size * sizeof(Element);
+}
+
+void BigInt::serialize( void* buf) const noexcept
+{
+	unsigned char* dest = (unsigned char*)buf;
+	std::memset( dest, 0, SerializeHeaderSize);
+	dest[ 0] = 'B';
+	dest[ 1] = 'C';
+	dest[ 2] = SerializeVersion;
+	dest[ 3] = m_sign ? SerializeFlagNegative : 0;
+	store_word( dest + 8, m_size);
+	dest += SerializeHeaderSize;
+	if (LittleEndian)
+	{
+		if (m_size) std::memcpy( dest, m_ar, m_size * sizeof(Element));
+	}
+	else
+	{
+		for (std::size_t ii = 0; ii < m_size; ++ii) store_word( dest + ii * sizeof(Element), m_ar[ ii]);
+	}
+}
+
+std::string BigInt::serialize() const
+{
+	std::string rt( serialized_size(), '\0');
+	serialize( &rt[0]);
+	return rt;
+}
+
+BigInt BigInt::deserialize( const void* buf, std::size_t bufsize)
+{
+	const unsigned char* src = (const unsigned char*)buf;
+	if (bufsize < SerializeHeaderSize || src[0] != 'B' || src[1] != 'C')
+	{
+		throw std::runtime_error( "not a serialized bcd number");
+	}
+	if (src[2] != SerializeVersion) throw std::runtime_error( "unsupported version of serialized bcd number");
+	std::uint64_t size = load_word( src + 8);
+	if ((src[3] & ~SerializeFlagNegative) || load_word( src) >> 32
+	||  size != (bufsize - SerializeHeaderSize) / sizeof(Element) || (bufsize - SerializeHeaderSize) % sizeof(Element))
+	{
+		throw std::runtime_error( "corrupt serialized bcd number");
+	}
+	const unsigned char* elements = src + SerializeHeaderSize;
+	bool sign = (src[3] & SerializeFlagNegative) != 0;
+	if (LittleEndian && (std::uintptr_t)elements % alignof(Element) == 0)
+	{
+		const Element* ar = (const Element*)elements;
+		check_serialized_elements( ar, size, sign);
+		return BigInt( const_cast<Element*>( ar), size, sign);
+	}
+	BigInt rt;
+	rt.allocate( size);
+	for (std::size_t ii = 0; ii < size; ++ii) rt.m_ar[ ii] = load_word( elements + ii * sizeof(Element));
+	check_serialized_elements( rt.m_ar, size, sign);
+	rt.m_sign = sign;
+	rt.m_nofDigits = count_digits( rt.m_ar, size);
+	return rt;
 }
 
 std::string BigInt::tostring() const
 {
+	BCD_STATISTICS_SCOPE( OpToString, m_size);
 	std::string rt;
 	const_iterator ii = begin(), ee = end();
 	if (ii == ee) return "0";
@@ -498,7 +1032,7 @@ void BigInt::const_iterator::increment() noexcept
 unsigned char BigInt::const_iterator::operator*() const
 {
 	unsigned char rt = (unsigned char)(m_ar[ m_idx-1] >> m_shf) & 0xf;
-	if (rt > 9) throw std::runtime_error( "corrupt bcd number");
+	if (CheckResults && rt > 9) throw std::runtime_error( "corrupt bcd number");
 	return rt;
 }
 
@@ -517,28 +1051,6 @@ bool BigInt::const_iterator::isle( const const_iterator& other) const noexcept
 	return m_idx>=other.m_idx || m_shf>=other.m_shf;
 }
 
-static BigInt::Element checkvalue( std::uint64_t a) noexcept
-{
-	// thanks to http://homepage.divms.uiowa.edu/~jones/bcd/bcd.html:
-	std::uint64_t t1,t2;
-	t1 = a + 0x0666666666666666ULL;
-	t2 = t1 ^ a;
-	return (t2 & 0x1111111111111110ULL);
-}
-
-static std::uint64_t add_bcd( std::uint64_t a, std::uint64_t b) noexcept
-{
-	// thanks to http://homepage.divms.uiowa.edu/~jones/bcd/bcd.html:
-	std::uint64_t t1,t2,t3,t4,t5,t6;
-	t1 = a + 0x0666666666666666ULL;
-	t2 = t1 + b;
-	t3 = t1 ^ b;
-	t4 = t2 ^ t3;
-	t5 = ~t4 & 0x1111111111111110ULL;
-	t6 = (t5 >> 2) | (t5 >> 3);
-	return t2 - t6;
-}
-
 static std::uint64_t tencomp( std::uint64_t a) noexcept
 {
 	// thanks to http://homepage.divms.uiowa.edu/~jones/bcd/bcd.html:
@@ -587,6 +1099,14 @@ bool BigInt::isValid() const noexcept
 	return (chkval == 0);
 }
 
+std::size_t BigInt::count_digits( const Element* ar, std::size_t size) noexcept
+{
+	// ... every digit is a nibble, the digits of the top element are its significant nibbles
+	if (!size) return 0;
+	Element top = ar[ size-1];
+	return (size-1) * NumDigits + (top ? (64 - __builtin_clzll( top) + 3) / 4 : 0);
+}
+
 bool BigInt::isNull() const noexcept
 {
 	const_iterator ii=begin(),ee=end();
@@ -595,7 +1115,7 @@ bool BigInt::isNull() const noexcept
 
 void BigInt::normalize()
 {
-	if (!isValid()) throw std::logic_error( "bad bcd calculation");
+	if (CheckResults && !isValid()) throw std::logic_error( "bad bcd calculation");
 	std::size_t ii = 0, nn = m_size;
 
 	for (ii=nn; ii>0; --ii)
@@ -611,10 +1131,12 @@ void BigInt::normalize()
 		m_sign = false;
 		m_size = 0;
 	}
+	m_nofDigits = count_digits( m_ar, m_size);
 }
 
 void BigInt::digits_addition( BigInt& rt, const BigInt& this_, const BigInt& opr)
 {
+	BCD_KERNEL_PROBE_SCOPE( "add", &rt, this_.m_size, opr.m_size);
 	Element carry;
 	std::size_t ii=0, nn = (opr.m_size > this_.m_size)?opr.m_size:this_.m_size;
 	if (nn == 0) return;
@@ -630,19 +1152,13 @@ void BigInt::digits_addition( BigInt& rt, const BigInt& this_, const BigInt& opr
 		carry = getcarry( res);
 		rt.m_ar[ ii] = res;
 	}
-	if (carry)
-	{
-		rt.m_ar[ nn++] = carry;
-		if (!rt.isValid()) throw std::logic_error( "bad bcd calculation");
-	}
-	else
-	{
-		rt.normalize();
-	}
+	rt.m_ar[ nn] = carry;
+	rt.normalize();
 }
 
 void BigInt::digits_subtraction( BigInt& rt, const BigInt& this_, const BigInt& opr)
 {
+	BCD_KERNEL_PROBE_SCOPE( "sub", &rt, this_.m_size, opr.m_size);
 	std::size_t ii = 0, mm = 0, nn = (opr.m_size > this_.m_size)?opr.m_size:this_.m_size;
 	if (nn == 0) return;
 	rt.allocate( nn);
@@ -666,12 +1182,13 @@ void BigInt::digits_subtraction( BigInt& rt, const BigInt& this_, const BigInt&
 	}
 	if (carry)
 	{
-		for (mm=nn; mm>0; mm--)
+		// ... the difference is negative, the result is its ten's complement, the +1 propagated over low zero elements
+		carry = 1;
+		for (mm=0; mm<nn; ++mm)
 		{
-			Element res = rt.m_ar[ mm-1];
-			if (mm>1) res = increment( res);
-			res = tencomp(res) & NumMask;
-			rt.m_ar[ mm-1] = res;
+			Element res = add_bcd( NinesMask - (rt.m_ar[ mm] & NumMask), carry);
+			carry = res >> NumHighShift;
+			rt.m_ar[ mm] = res & NumMask;
 		}
 		rt.m_sign = !rt.m_sign;
 	}
@@ -723,6 +1240,12 @@ void BigInt::digits_shift( BigInt& rt, const BigInt& this_, int nof_digits)
 		unsigned int sfh = (unsigned int)nof_digits % NumDigits;
 		std::size_t ii,nn;
 
+		if (ofs >= this_.m_size)
+		{
+			// ... all digits shifted out
+			rt.allocate( 0);
+			return;
+		}
 		rt.allocate( this_.m_size - ofs + 1);
 		rt.m_sign = this_.m_sign;
 		if (sfh == 0)
@@ -754,22 +1277,29 @@ void BigInt::digits_shift( BigInt& rt, const BigInt& this_, int nof_digits)
 void BigInt::digits_cut( BigInt& rt, const BigInt& this_, unsigned int nof_digits)
 {
 	unsigned int ofs = (unsigned int)nof_digits / NumDigits;
-	unsigned char sfh = (unsigned char)nof_digits % NumDigits;
+	unsigned char sfh = (unsigned char)(nof_digits % NumDigits);
 	std::size_t ii,nn;
 
+	if (ofs >= this_.m_size)
+	{
+		// ... the number has not more digits than the ones kept
+		rt.copy( this_);
+		return;
+	}
 	rt.allocate( ofs + 1);
 	rt.m_sign = this_.m_sign;
 	for (ii=0,nn=ofs; ii<nn; ++ii)
 	{
 		rt.m_ar[ ii] = this_.m_ar[ ii];
 	}
-	unsigned int mask = NumMask >> ((NumDigits - sfh) * 4);
+	Element mask = NumMask >> ((NumDigits - sfh) * 4);
 	rt.m_ar[ ii] = this_.m_ar[ ii] & mask;
 	rt.normalize();
 }
 
 BigInt BigInt::shift( int digits) const
 {
+	BCD_STATISTICS_SCOPE( OpShift, m_size);
 	BigInt rt;
 	digits_shift( rt, *this, digits);
 	return rt;
@@ -777,6 +1307,7 @@ BigInt BigInt::shift( int digits) const
 
 BigInt BigInt::cut( unsigned int digits) const
 {
+	BCD_STATISTICS_SCOPE( OpCut, m_size);
 	BigInt rt;
 	digits_cut( rt, *this, digits);
 	return rt;
@@ -784,6 +1315,7 @@ BigInt BigInt::cut( unsigned int digits) const
 
 BigInt BigInt::round( const BigInt& gran) const
 {
+	BCD_STATISTICS_SCOPE( OpRound, m_size);
 	unsigned int nn = gran.nof_digits();
 	if (gran.m_sign || !nn) throw std::runtime_error( "rounding granularity must be a positive number");
 
@@ -812,15 +1344,6 @@ BigInt BigInt::round( const BigInt& gran) const
 	}
 }
 
-void BigInt::digits_16_multiplication( BigInt& rt, const BigInt& this_)
-{
-	BigInt x2,x4,x8;
-	digits_addition( x2, this_, this_);
-	digits_addition( x4, x2, x2);
-	digits_addition( x8, x4, x4);
-	digits_addition( rt, x8, x8);
-}
-
 void BigInt::digits_nibble_multiplication( BigInt& rt, const BigInt& this_, unsigned char factor)
 {
 	BigInt x2,x4,x8;
@@ -839,6 +1362,7 @@ void BigInt::digits_nibble_multiplication( BigInt& rt, const BigInt& this_, unsi
 	switch (factor)
 	{
 		case 0:
+			rt.allocate( 0);
 		break;
 		case 1:
 			rt.copy( this_);
@@ -913,30 +1437,26 @@ void BigInt::digits_nibble_multiplication( BigInt& rt, const BigInt& this_, unsi
 
 void BigInt::digits_multiplication( BigInt& rt, const BigInt& this_, FactorType factor)
 {
-	if (factor == 0)
-	{
-		rt.allocate( 0);
-		return;
-	}
-	BigInt part,fac;
-	digits_nibble_multiplication( rt, this_, factor & 0x0f);
-	fac.copy( this_);
-	factor >>= 4;
-	while (factor > 0)
+	BCD_KERNEL_PROBE_SCOPE( "mul_scalar", &rt, this_.m_size, 1);
+	// ... element by element in binary, the product of an element with the factor plus the carry fits into 128 bits
+	std::size_t ii = 0, nn = this_.m_size;
+	rt.allocate( nn + 2);
+	DoubleElement carry = 0;
+	for (; ii < nn; ++ii)
 	{
-		BigInt newfac;
-		digits_16_multiplication( newfac, fac);
-		fac.swap( newfac);
-		digits_nibble_multiplication( part, fac, factor & 0x0f);
-		BigInt sum;
-		digits_addition( sum, part, rt);
-		sum.swap( rt);
-		factor >>= 4;
+		carry += (DoubleElement)bcd_to_uint( this_.m_ar[ ii]) * factor;
+		rt.m_ar[ ii] = uint_to_bcd( (std::uint64_t)(carry % ElementBase));
+		carry /= ElementBase;
 	}
+	rt.m_ar[ nn] = uint_to_bcd( (std::uint64_t)(carry % ElementBase));
+	rt.m_ar[ nn+1] = uint_to_bcd( (std::uint64_t)(carry / ElementBase));
+	rt.m_sign = this_.m_sign;
+	rt.trim();
 }
 
 void BigInt::digits_multiplication( BigInt& rt, const BigInt& this_, const BigInt& opr)
 {
+	BCD_KERNEL_PROBE_SCOPE( "mul", &rt, this_.m_size, opr.m_size);
 	const_iterator ii = opr.begin(), ee = opr.end();
 	if (ii == ee) return;
 
@@ -953,27 +1473,97 @@ void BigInt::digits_multiplication( BigInt& rt, const BigInt& this_, const BigIn
 	}
 }
 
-static int estimate_shifts( const BigInt& this_, const BigInt& match)
+static std::atomic<std::size_t> g_parallelThreshold( DefaultParallelThreshold);
+
+void BigInt::setNofThreads( unsigned int nofThreads)
 {
-	int rt = (int)(this_.nof_digits() - match.nof_digits());
-	if (*this_.begin() == *match.begin())
-	{
-		return rt;
-	}
-	else
-	{
-		return rt - 1;
-	}
+	ThreadPool::instance().setNofThreads( nofThreads);
 }
 
-void BigInt::digits_division( BigInt& result, BigInt& remainder, const BigInt& this_, const BigInt& opr)
+void BigInt::setParallelThreshold( std::size_t nofDigits)
 {
-	remainder.copy( this_);
-	remainder.m_sign = false;
-
-	if (opr.isNull()) throw std::runtime_error( "division by zero");
+	g_parallelThreshold = nofDigits;
+}
 
-	while (!remainder.isNull() && remainder.compare( opr) >= 0)
+void BigInt::setReferenceMode( bool enabled) noexcept
+{
+	g_referenceMode = enabled;
+}
+
+bool BigInt::referenceMode() noexcept
+{
+	return reference_mode();
+}
+
+bool BigInt::use_parallel_multiplication( const BigInt& this_, const BigInt& opr) noexcept
+{
+	if (reference_mode() || ThreadPool::instance().nofThreads() <= 1) return false;
+	double threshold = (double)g_parallelThreshold;
+	return (double)this_.m_size * NumDigits * (double)opr.m_size * NumDigits >= threshold * threshold;
+}
+
+void BigInt::digits_parallel_multiplication( BigInt& rt, const BigInt& this_, const BigInt& opr)
+{
+	BCD_KERNEL_PROBE_SCOPE( "mul_parallel", &rt, this_.m_size, opr.m_size);
+	// ... split the bigger operand into element aligned chunks multiplied in parallel with the smaller one
+	const BigInt& big = (this_.m_size >= opr.m_size) ? this_ : opr;
+	const BigInt& small = (&big == &this_) ? opr : this_;
+	ThreadPool& pool = ThreadPool::instance();
+
+	std::size_t nofChunks = pool.nofThreads() * ParallelChunksPerThread;
+	std::size_t chunksize = (big.m_size + nofChunks - 1) / nofChunks;
+	nofChunks = (big.m_size + chunksize - 1) / chunksize;
+
+	std::vector<BigInt> chunks( nofChunks);
+	std::vector<BigInt> parts( nofChunks);
+	std::vector<ThreadPool::Task> tasks;
+	tasks.reserve( nofChunks);
+	for (std::size_t ci = 0; ci < nofChunks; ++ci)
+	{
+		std::size_t ofs = ci * chunksize;
+		std::size_t size = std::min( chunksize, big.m_size - ofs);
+		chunks[ ci].allocate( size);
+		std::memcpy( chunks[ ci].m_ar, big.m_ar + ofs, size * sizeof(Element));
+		chunks[ ci].normalize();
+		tasks.push_back( [&small,&chunks,&parts,ci]{ digits_multiplication( parts[ ci], small, chunks[ ci]); });
+	}
+	pool.run( tasks);
+
+	rt.allocate( 0);
+	for (std::size_t ci = 0; ci < nofChunks; ++ci)
+	{
+		if (parts[ ci].isNull()) continue;
+		BigInt shifted, sum;
+		digits_shift( shifted, parts[ ci], ci * chunksize * NumDigits);
+		digits_addition( sum, rt, shifted);
+		rt.swap( sum);
+	}
+}
+
+static int estimate_shifts( const BigInt& this_, const BigInt& match)
+{
+	int rt = (int)(this_.nof_digits() - match.nof_digits());
+	if (*this_.begin() == *match.begin())
+	{
+		return rt;
+	}
+	else
+	{
+		return rt - 1;
+	}
+}
+
+void BigInt::digits_division( BigInt& result, BigInt& remainder, const BigInt& this_, const BigInt& opr)
+{
+	BCD_KERNEL_PROBE_SCOPE( "div", &result, this_.m_size, opr.m_size);
+	remainder.copy( this_);
+	remainder.m_sign = false;
+
+	if (opr.isNull()) throw std::runtime_error( "division by zero");
+	// ... the remainder is compared with the magnitude of the divisor, as the remainder has no sign
+	const BigInt divisor = BigInt::constant( opr.m_ar, opr.m_size, false);
+
+	while (!remainder.isNull() && remainder.compare( divisor) >= 0)
 	{
 		FactorType estimate = division_estimate( remainder, opr);
 		if (estimate == 0) throw std::runtime_error( "illegal state calculating division estimate");
@@ -1018,36 +1608,203 @@ void BigInt::digits_division( BigInt& result, BigInt& remainder, const BigInt& t
 	}
 }
 
+template <unsigned int N>
+static void load_elements( BigInt::Element* dest, const BigInt::Element* ar, std::size_t size) noexcept
+{
+	unrolled<N>( [&]( std::size_t ii){dest[ ii] = ii < size ? ar[ ii] : 0;});
+}
+
+void BigInt::trim() noexcept
+{
+	while (m_size && !m_ar[ m_size-1]) --m_size;
+	if (!m_size) m_sign = false;
+	m_nofDigits = count_digits( m_ar, m_size);
+}
+
+template <unsigned int N>
+void BigInt::small_addition( BigInt& rt, const BigInt& this_, const BigInt& opr, bool subtract)
+{
+	Element aa[ N], bb[ N];
+	load_elements<N>( aa, this_.m_ar, this_.m_size);
+	load_elements<N>( bb, opr.m_ar, opr.m_size);
+	rt.allocate( N+1);
+	rt.m_sign = this_.m_sign;
+	Element carry = subtract ? 1 : 0;
+	unrolled<N>( [&]( std::size_t ii){
+		Element res = add_bcd( add_bcd( aa[ ii], subtract ? (NinesMask - bb[ ii]) : bb[ ii]), carry);
+		carry = res >> NumHighShift;
+		rt.m_ar[ ii] = res & NumMask;
+	});
+	if (!subtract)
+	{
+		rt.m_ar[ N] = carry;
+	}
+	else if (!carry)
+	{
+		// ... the difference is negative, the result is its ten's complement
+		carry = 1;
+		unrolled<N>( [&]( std::size_t ii){
+			Element res = add_bcd( NinesMask - rt.m_ar[ ii], carry);
+			carry = res >> NumHighShift;
+			rt.m_ar[ ii] = res & NumMask;
+		});
+		rt.m_sign = !rt.m_sign;
+	}
+	rt.trim();
+}
+
+template <unsigned int N>
+void BigInt::small_multiplication( BigInt& rt, const BigInt& this_, const BigInt& opr)
+{
+	// ... schoolbook multiplication in binary with base 10^15, the column sums fit into 128 bits
+	Element aa[ N], bb[ N];
+	DoubleElement col[ 2*N];
+	load_elements<N>( aa, this_.m_ar, this_.m_size);
+	load_elements<N>( bb, opr.m_ar, opr.m_size);
+	unrolled<N>( [&]( std::size_t ii){aa[ ii] = bcd_to_uint( aa[ ii]); bb[ ii] = bcd_to_uint( bb[ ii]);});
+	unrolled<2*N>( [&]( std::size_t kk){col[ kk] = 0;});
+	unrolled<N>( [&]( std::size_t ii){
+		unrolled<N>( [&]( std::size_t jj){col[ ii+jj] += (DoubleElement)aa[ ii] * bb[ jj];});
+	});
+	// ... the product has at most as many elements as the operands together, the columns above are zero
+	std::size_t size = this_.m_size + opr.m_size;
+	rt.allocate( size);
+	DoubleElement carry = 0;
+	unrolled<2*N>( [&]( std::size_t kk){
+		carry += col[ kk];
+		if (kk < size) rt.m_ar[ kk] = uint_to_bcd( (std::uint64_t)(carry % ElementBase));
+		carry /= ElementBase;
+	});
+	rt.m_sign = (this_.m_sign != opr.m_sign);
+	rt.trim();
+}
+
+template <unsigned int N>
+int BigInt::small_compare( const BigInt& this_, const BigInt& opr) noexcept
+{
+	int rt = 0;
+	unrolled<N>( [&]( std::size_t ii){
+		std::size_t kk = N-1-ii;
+		rt = rt ? rt : (this_.m_ar[ kk] > opr.m_ar[ kk]) - (this_.m_ar[ kk] < opr.m_ar[ kk]);
+	});
+	return this_.m_sign ? -rt : rt;
+}
+
+// ... numbers of at most 18 digits fit into a machine integer, multiplications and divisions of them are evaluated natively if the result does not overflow,
+//	additions are not, the conversions cost more than the addition of the digits
+bool BigInt::native_value( long& val) const noexcept
+{
+	if (m_size > 2 || (m_size == 2 && m_ar[ 1] >= 0x1000)) return false;
+	std::uint64_t mag = 0;
+	if (m_size > 1) mag = bcd_to_uint( m_ar[ 1]) * ElementBase;
+	if (m_size > 0) mag += bcd_to_uint( m_ar[ 0]);
+	val = m_sign ? -(long)mag : (long)mag;
+	return true;
+}
+
+void BigInt::assign_native( long val)
+{
+	std::uint64_t mag = long_magnitude( val);
+	allocate( mag >= ElementBase ? 2 : (mag ? 1 : 0));
+	if (m_size > 0) m_ar[ 0] = uint_to_bcd( mag % ElementBase);
+	if (m_size > 1) m_ar[ 1] = uint_to_bcd( mag / ElementBase);
+	m_sign = (val < 0);
+	m_nofDigits = count_digits( m_ar, m_size);
+}
+
 BigInt BigInt::add( const BigInt& opr) const
 {
 	BigInt rt;
-	if (m_sign == opr.m_sign)
+	rt.assign_add( *this, opr);
+	return rt;
+}
+
+void BigInt::assign_add( const BigInt& this_, const BigInt& opr)
+{
+	BCD_STATISTICS_SCOPE( OpAdd, std::max( this_.m_size, opr.m_size));
+	allocate( 0);
+	switch (reference_mode() ? 0 : std::max( this_.m_size, opr.m_size))
 	{
-		digits_addition( rt, *this, opr);
+		case 1: small_addition<1>( *this, this_, opr, this_.m_sign != opr.m_sign); return;
+		case 2: small_addition<2>( *this, this_, opr, this_.m_sign != opr.m_sign); return;
+		case 3: small_addition<3>( *this, this_, opr, this_.m_sign != opr.m_sign); return;
+		case 4: small_addition<4>( *this, this_, opr, this_.m_sign != opr.m_sign); return;
+		default: break;
+	}
+	if (this_.m_sign == opr.m_sign)
+	{
+		digits_addition( *this, this_, opr);
 	}
 	else
 	{
-		digits_subtraction( rt, *this, opr);
+		digits_subtraction( *this, this_, opr);
 	}
-	return rt;
+}
+
+// ... machine integer converted to elements on the stack, referenced by a number not owning them
+struct LongOperand
+{
+	BigInt::Element ar[ 2];
+	BigInt value;
+
+	explicit LongOperand( long num) noexcept
+		:ar{ uint_to_bcd( long_magnitude( num) % ElementBase), uint_to_bcd( long_magnitude( num) / ElementBase)}
+		,value( BigInt::constant( ar, ar[ 1] ? 2 : (ar[ 0] ? 1 : 0), num < 0)){}
+};
+
+BigInt BigInt::add( long opr) const
+{
+	return add( LongOperand( opr).value);
+}
+
+void BigInt::assign_add( const BigInt& this_, long opr)
+{
+	assign_add( this_, LongOperand( opr).value);
+}
+
+BigInt BigInt::sub( long opr) const
+{
+	return sub( LongOperand( opr).value);
+}
+
+void BigInt::assign_sub( const BigInt& this_, long opr)
+{
+	assign_sub( this_, LongOperand( opr).value);
 }
 
 BigInt BigInt::sub( const BigInt& opr) const
 {
 	BigInt rt;
-	if (m_sign == opr.m_sign)
+	rt.assign_sub( *this, opr);
+	return rt;
+}
+
+void BigInt::assign_sub( const BigInt& this_, const BigInt& opr)
+{
+	BCD_STATISTICS_SCOPE( OpSub, std::max( this_.m_size, opr.m_size));
+	allocate( 0);
+	switch (reference_mode() ? 0 : std::max( this_.m_size, opr.m_size))
 	{
-		digits_subtraction( rt, *this, opr);
+		case 1: small_addition<1>( *this, this_, opr, this_.m_sign == opr.m_sign); return;
+		case 2: small_addition<2>( *this, this_, opr, this_.m_sign == opr.m_sign); return;
+		case 3: small_addition<3>( *this, this_, opr, this_.m_sign == opr.m_sign); return;
+		case 4: small_addition<4>( *this, this_, opr, this_.m_sign == opr.m_sign); return;
+		default: break;
+	}
+	if (this_.m_sign == opr.m_sign)
+	{
+		digits_subtraction( *this, this_, opr);
 	}
 	else
 	{
-		digits_addition( rt, *this, opr);
+		digits_addition( *this, this_, opr);
 	}
-	return rt;
 }
 
 BigInt BigInt::mul( FactorType opr) const
 {
+	BCD_STATISTICS_SCOPE( OpMul, m_size);
+	if (reference_mode()) return mul( BigInt( (unsigned long)opr));
 	BigInt val;
 	digits_multiplication( val, *this, opr);
 	return val;
@@ -1055,44 +1812,91 @@ BigInt BigInt::mul( FactorType opr) const
 
 BigInt BigInt::mul( long opr) const
 {
-	bool ng = false;
-	if (opr < 0)
-	{
-		opr = -opr;
-		ng = true;
-	}
 	BigInt val;
-	digits_multiplication( val, *this, opr);
-	val.m_sign ^= ng;
+	val.assign_mul( *this, opr);
 	return val;
 }
 
+void BigInt::assign_mul( const BigInt& this_, long opr)
+{
+	BCD_STATISTICS_SCOPE( OpMul, this_.m_size);
+	if (reference_mode())
+	{
+		assign_mul( this_, LongOperand( opr).value);
+		return;
+	}
+	digits_multiplication( *this, this_, (FactorType)long_magnitude( opr));
+	m_sign = (this_.m_sign != (opr < 0)) && m_size;
+}
+
 BigInt BigInt::mul( const BigInt& opr) const
 {
 	BigInt val;
-	digits_multiplication( val, *this, opr);
+	val.assign_mul( *this, opr);
 	return val;
 }
 
+void BigInt::assign_mul( const BigInt& this_, const BigInt& opr)
+{
+	BCD_STATISTICS_SCOPE( OpMul, std::max( this_.m_size, opr.m_size));
+	long aa, bb, res;
+	if (!reference_mode() && this_.native_value( aa) && opr.native_value( bb) && !__builtin_mul_overflow( aa, bb, &res))
+	{
+		assign_native( res);
+		return;
+	}
+	allocate( 0);
+	switch (reference_mode() ? 0 : std::max( this_.m_size, opr.m_size))
+	{
+		case 1: small_multiplication<1>( *this, this_, opr); return;
+		case 2: small_multiplication<2>( *this, this_, opr); return;
+		case 3: small_multiplication<3>( *this, this_, opr); return;
+		case 4: small_multiplication<4>( *this, this_, opr); return;
+		default: break;
+	}
+	if (use_parallel_multiplication( this_, opr))
+	{
+		digits_parallel_multiplication( *this, this_, opr);
+	}
+	else
+	{
+		digits_multiplication( *this, this_, opr);
+	}
+	m_sign = (this_.m_sign != opr.m_sign);
+	normalize();
+}
+
+int BigInt::compare( long o) const noexcept
+{
+	return compare( LongOperand( o).value);
+}
+
 int BigInt::compare( const BigInt& o) const noexcept
 {
+	BCD_STATISTICS_SCOPE( OpCompare, std::max( m_size, o.m_size));
 	if (sign() != o.sign())
 	{
 		return (sign() == '-')?-1:+1;
 	}
-	else
+	if (m_size == o.m_size && !reference_mode())
 	{
-		int resOtherSmaller = (sign() == '-')?-1:+1;
-		BigInt::const_iterator ii = begin(), ee = end(), oo = o.begin();
-		if (ii.size() > oo.size()) return resOtherSmaller;
-		if (ii.size() < oo.size()) return -resOtherSmaller;
-		for (; ii != ee; ++ii,++oo)
+		switch (m_size)
 		{
-			if (*ii > *oo) return resOtherSmaller;
-			if (*ii < *oo) return -resOtherSmaller;
+			case 1: return small_compare<1>( *this, o);
+			case 2: return small_compare<2>( *this, o);
+			case 3: return small_compare<3>( *this, o);
+			case 4: return small_compare<4>( *this, o);
+			default: break;
 		}
-		return 0;
 	}
+	// ... packed BCD elements order like their values, the numbers are compared element wise from the top
+	int resOtherSmaller = (sign() == '-')?-1:+1;
+	if (m_size != o.m_size) return (m_size > o.m_size) ? resOtherSmaller : -resOtherSmaller;
+	for (std::size_t ii = m_size; ii > 0; --ii)
+	{
+		if (m_ar[ ii-1] != o.m_ar[ ii-1]) return (m_ar[ ii-1] > o.m_ar[ ii-1]) ? resOtherSmaller : -resOtherSmaller;
+	}
+	return 0;
 }
 
 static BigInt::FactorType estimate_to_uint( double val) noexcept
@@ -1168,28 +1972,102 @@ BigInt BigInt::estimate_as_bcd( FactorType estimate, int estshift)
 
 std::pair<BigInt,BigInt> BigInt::div( const BigInt& opr) const
 {
+	BCD_STATISTICS_SCOPE( OpDiv, std::max( m_size, opr.m_size));
 	std::pair<BigInt,BigInt> rt;
+	long aa, bb;
+	if (!reference_mode() && native_value( aa) && opr.native_value( bb) && bb)
+	{
+		// ... the remainder is not negative, the magnitudes are divided
+		std::uint64_t am = long_magnitude( aa), bm = long_magnitude( bb);
+		rt.first.assign_native( (aa < 0) != (bb < 0) ? -(long)(am / bm) : (long)(am / bm));
+		rt.second.assign_native( (long)(am % bm));
+		return rt;
+	}
 	digits_division( rt.first, rt.second, *this, opr);
 	return rt;
 }
 
 BigInt BigInt::mod( const BigInt& opr) const
 {
+	BCD_STATISTICS_SCOPE( OpMod, std::max( m_size, opr.m_size));
+	BigInt rt;
+	rt.assign_mod( *this, opr);
+	return rt;
+}
+
+void BigInt::assign_mod( const BigInt& this_, const BigInt& opr)
+{
+	BCD_STATISTICS_SCOPE( OpMod, std::max( this_.m_size, opr.m_size));
+	long aa, bb;
+	if (!reference_mode() && this_.native_value( aa) && opr.native_value( bb) && bb)
+	{
+		assign_native( (long)(long_magnitude( aa) % long_magnitude( bb)));
+		return;
+	}
+	// ... the remainder is computed in temporaries and copied, it is not larger than the divisor
 	std::pair<BigInt,BigInt> rt;
-	digits_division( rt.first, rt.second, *this, opr);
-	return rt.second;
+	digits_division( rt.first, rt.second, this_, opr);
+	copy( rt.second);
+}
+
+std::uint64_t BigInt::digits_short_division( BigInt* result, const BigInt& this_, std::uint64_t divisor)
+{
+	BCD_KERNEL_PROBE_SCOPE( "div_scalar", result, this_.m_size, 1);
+	if (divisor == 0) throw std::runtime_error( "division by zero");
+	// ... the remainder is smaller than the divisor, so every quotient element is smaller than the element base
+	if (result) result->allocate( this_.m_size);
+	DoubleElement rem = 0;
+	for (std::size_t ii = this_.m_size; ii > 0; --ii)
+	{
+		rem = rem * ElementBase + bcd_to_uint( this_.m_ar[ ii-1]);
+		if (result) result->m_ar[ ii-1] = uint_to_bcd( (std::uint64_t)(rem / divisor));
+		rem %= divisor;
+	}
+	return (std::uint64_t)rem;
+}
+
+std::pair<BigInt,BigInt> BigInt::div( long opr) const
+{
+	BCD_STATISTICS_SCOPE( OpDiv, m_size);
+	if (reference_mode()) return div( LongOperand( opr).value);
+	std::pair<BigInt,BigInt> rt;
+	std::uint64_t rem = digits_short_division( &rt.first, *this, long_magnitude( opr));
+	rt.first.m_sign = (m_sign != (opr < 0));
+	rt.first.trim();
+	rt.second.init( (unsigned long)rem);
+	return rt;
+}
+
+BigInt BigInt::mod( long opr) const
+{
+	BCD_STATISTICS_SCOPE( OpMod, m_size);
+	if (reference_mode()) return mod( LongOperand( opr).value);
+	return BigInt( (unsigned long)digits_short_division( nullptr, *this, long_magnitude( opr)));
+}
+
+void BigInt::assign_mod( const BigInt& this_, long opr)
+{
+	BCD_STATISTICS_SCOPE( OpMod, this_.m_size);
+	if (reference_mode())
+	{
+		assign_mod( this_, LongOperand( opr).value);
+		return;
+	}
+	init( (unsigned long)digits_short_division( nullptr, this_, long_magnitude( opr)));
 }
 
 BigInt BigInt::neg() const
 {
+	BCD_STATISTICS_SCOPE( OpNeg, m_size);
+	// ... the copy shares the elements, only the sign differs
 	BigInt rt(*this);
-	rt.m_sign = !rt.m_sign;
-	rt.normalize();
+	rt.m_sign = !rt.m_sign && rt.m_size;
 	return rt;
 }
 
 BigInt BigInt::pow( unsigned long opr) const
 {
+	BCD_STATISTICS_SCOPE( OpPow, m_size);
 	BigInt ar[ sizeof opr * 8];
 	std::size_t ai = 1, ae = sizeof opr * 8;
 	std::size_t mask = 1;
@@ -1198,7 +2076,7 @@ BigInt BigInt::pow( unsigned long opr) const
 	{
 		ar[ ai] = ar[ ai-1] * ar[ ai-1];
 	}
-	BigInt rt( "1", 1);
+	BigInt rt = 1_bcd;
 	mask = 1;
 	ai = 0;
 	for (; ai != ae && (unsigned long)mask <= opr; ++ai,mask <<= 1)
@@ -1211,11 +2089,432 @@ BigInt BigInt::pow( unsigned long opr) const
 	return rt;
 }
 
+static double estimate_log10( const BigInt& this_)
+{
+	double lead = 0.0;
+	std::size_t kk = 0, nn = this_.nof_digits();
+
+	BigInt::const_iterator ii = this_.begin(), ee = this_.end();
+	for (; kk<17 && ii != ee; ++kk,++ii)
+	{
+		lead = lead * 10.0 + *ii;
+	}
+	return std::log10( lead) + (double)(nn - kk);
+}
+
+BigInt BigInt::root_upper_bound( const BigInt& this_, unsigned int nn)
+{
+	std::size_t rootdigits = (this_.nof_digits() + nn - 1) / nn;
+	if (rootdigits <= NumDigits)
+	{
+		// ... initial guess from the leading digits, with a margin covering the rounding errors
+		double est = std::pow( 10.0, estimate_log10( this_) / nn);
+		return BigInt( (unsigned long)(est + est * 1E-12 + 2.0));
+	}
+	else
+	{
+		// ... the root of the number without its kk*nn last digits gives us the upper half of the root digits
+		unsigned int kk = (rootdigits - 1) / 2;
+		BigInt head, head_remainder;
+		digits_root( head, head_remainder, this_.shift( -(int)(kk * nn)), nn);
+		return (head + 1_bcd).shift( kk);
+	}
+}
+
+void BigInt::digits_root( BigInt& result, BigInt& remainder, const BigInt& this_, unsigned int nn)
+{
+	BCD_KERNEL_PROBE_SCOPE( "root", &result, this_.m_size, 1);
+	if (this_.m_sign) throw std::runtime_error( "root of negative number");
+	if (nn == 0) throw std::runtime_error( "zero root of a number");
+	if (nn == 1 || this_.isNull())
+	{
+		result.copy( this_);
+		remainder.init();
+		return;
+	}
+	// Newton iteration x' = ((nn-1)*x + this / x^(nn-1)) / nn, starting from an upper bound,
+	// ... decreases monotonically until it reaches the floor of the root:
+	BigInt divisor( (unsigned long)nn);
+	BigInt xx = root_upper_bound( this_, nn);
+	for (;;)
+	{
+		BigInt quot = this_.div( xx.pow( nn-1)).first;
+		BigInt yy = (xx.mul( (FactorType)(nn-1)) + quot).div( divisor).first;
+		if (yy.compare( xx) >= 0) break;
+		xx.swap( yy);
+	}
+	remainder = this_ - xx.pow( nn);
+	result.swap( xx);
+}
+
+std::pair<BigInt,BigInt> BigInt::isqrt() const
+{
+	return iroot( 2);
+}
+
+std::pair<BigInt,BigInt> BigInt::iroot( unsigned int nn) const
+{
+	BCD_STATISTICS_SCOPE( OpRoot, m_size);
+	std::pair<BigInt,BigInt> rt;
+	digits_root( rt.first, rt.second, *this, nn);
+	return rt;
+}
+
+void BigInt::digits_range_product( BigInt& rt, FactorType from, FactorType to)
+{
+	if (to > from && to - from > ProductLeafSize)
+	{
+		FactorType mid = from + (to - from) / 2;
+		BigInt left, right;
+		digits_range_product( left, from, mid);
+		digits_range_product( right, mid, to);
+		BigInt prod = left.mul( right);
+		rt.swap( prod);
+	}
+	else
+	{
+		// ... leaf: collect as many factors as fit into one scalar factor before multiplying
+		BigInt part( 1L);
+		FactorType factor = 1;
+		for (FactorType ii = from; ii < to; ++ii)
+		{
+			if (factor > std::numeric_limits<FactorType>::max() / ii)
+			{
+				part = part.mul( factor);
+				factor = 1;
+			}
+			factor *= ii;
+		}
+		BigInt prod = part.mul( factor);
+		rt.swap( prod);
+	}
+}
+
+void BigInt::digits_factor_product( BigInt& rt, const FactorType* factors, std::size_t nofFactors)
+{
+	if (nofFactors > ProductLeafSize)
+	{
+		std::size_t mid = nofFactors / 2;
+		BigInt left, right;
+		digits_factor_product( left, factors, mid);
+		digits_factor_product( right, factors + mid, nofFactors - mid);
+		BigInt prod = left.mul( right);
+		rt.swap( prod);
+	}
+	else
+	{
+		BigInt part( 1L);
+		FactorType factor = 1;
+		for (std::size_t fi = 0; fi < nofFactors; ++fi)
+		{
+			if (factor > std::numeric_limits<FactorType>::max() / factors[ fi])
+			{
+				part = part.mul( factor);
+				factor = 1;
+			}
+			factor *= factors[ fi];
+		}
+		BigInt prod = part.mul( factor);
+		rt.swap( prod);
+	}
+}
+
+void BigInt::digits_product( BigInt& rt, const BigInt* const* factors, std::size_t nofFactors)
+{
+	BCD_KERNEL_PROBE_SCOPE( "product", &rt, nofFactors, 0);
+	ThreadPool& pool = ThreadPool::instance();
+	if (!reference_mode() && pool.nofThreads() > 1 && nofFactors >= ParallelMinFactors)
+	{
+		// ... the products of the subranges are evaluated in parallel, then combined by the product tree
+		std::size_t nofChunks = std::min( nofFactors, (std::size_t)pool.nofThreads() * ParallelChunksPerThread);
+		std::vector<BigInt> parts( nofChunks);
+		std::vector<const BigInt*> partptrs( nofChunks);
+		std::vector<ThreadPool::Task> tasks;
+		tasks.reserve( nofChunks);
+		for (std::size_t ci = 0; ci < nofChunks; ++ci)
+		{
+			std::size_t start = ci * nofFactors / nofChunks;
+			std::size_t end = (ci+1) * nofFactors / nofChunks;
+			partptrs[ ci] = &parts[ ci];
+			tasks.push_back( [&parts,factors,ci,start,end]{ digits_sequential_product( parts[ ci], factors + start, end - start); });
+		}
+		pool.run( tasks);
+		digits_sequential_product( rt, partptrs.data(), nofChunks);
+	}
+	else
+	{
+		digits_sequential_product( rt, factors, nofFactors);
+	}
+}
+
+void BigInt::digits_sequential_product( BigInt& rt, const BigInt* const* factors, std::size_t nofFactors)
+{
+	if (nofFactors == 0)
+	{
+		rt.init( 1L);
+	}
+	else if (nofFactors == 1)
+	{
+		rt.copy( *factors[ 0]);
+	}
+	else
+	{
+		std::size_t mid = nofFactors / 2;
+		BigInt left, right;
+		digits_sequential_product( left, factors, mid);
+		digits_sequential_product( right, factors + mid, nofFactors - mid);
+		BigInt prod = left.mul( right);
+		rt.swap( prod);
+	}
+}
+
+struct BigInt::Accumulator
+{
+	std::vector<std::uint64_t> pos;	///< binary sums of the elements of the positive summands
+	std::vector<std::uint64_t> neg;	///< binary sums of the elements of the negative summands
+	std::size_t nofAdds;		///< number of additions since the last carry normalization
+
+	Accumulator() :pos(),neg(),nofAdds(0){}
+
+	static void add( std::vector<std::uint64_t>& sum, const BigInt& val)
+	{
+		if (sum.size() < val.m_size) sum.resize( val.m_size, 0);
+		for (std::size_t ii = 0; ii < val.m_size; ++ii)
+		{
+			sum[ ii] += bcd_to_uint( val.m_ar[ ii]);
+		}
+	}
+	static void normalize( std::vector<std::uint64_t>& sum)
+	{
+		std::uint64_t carry = 0;
+		for (std::size_t ii = 0; ii < sum.size(); ++ii)
+		{
+			sum[ ii] += carry;
+			carry = sum[ ii] / ElementBase;
+			sum[ ii] %= ElementBase;
+		}
+		for (; carry; carry /= ElementBase)
+		{
+			sum.push_back( carry % ElementBase);
+		}
+	}
+	// ... the element sums stay below 2^64 as long as the carries are normalized every SumCarryInterval additions
+	void add( const BigInt& val, bool negate = false)
+	{
+		if (++nofAdds == SumCarryInterval) normalize();
+		add( (val.m_sign != negate) ? neg : pos, val);
+	}
+	void add( const Accumulator& o)
+	{
+		if (++nofAdds == SumCarryInterval) normalize();
+		if (pos.size() < o.pos.size()) pos.resize( o.pos.size(), 0);
+		if (neg.size() < o.neg.size()) neg.resize( o.neg.size(), 0);
+		for (std::size_t ii = 0; ii < o.pos.size(); ++ii) pos[ ii] += o.pos[ ii];
+		for (std::size_t ii = 0; ii < o.neg.size(); ++ii) neg[ ii] += o.neg[ ii];
+	}
+	void normalize()
+	{
+		normalize( pos);
+		normalize( neg);
+		nofAdds = 0;
+	}
+	static void get( BigInt& rt, const std::vector<std::uint64_t>& sum)
+	{
+		rt.allocate( sum.size());
+		for (std::size_t ii = 0; ii < sum.size(); ++ii)
+		{
+			rt.m_ar[ ii] = uint_to_bcd( sum[ ii]);
+		}
+		rt.normalize();
+	}
+	void get( BigInt& rt)
+	{
+		normalize();
+		BigInt posval, negval;
+		get( posval, pos);
+		get( negval, neg);
+		BigInt res = posval.sub( negval);
+		rt.swap( res);
+	}
+};
+
+void BigInt::digits_sum( BigInt& rt, const BigInt* const* summands, const BigInt* const* factors, std::size_t nofSummands)
+{
+	BCD_KERNEL_PROBE_SCOPE( factors ? "dot" : "sum", &rt, nofSummands, 0);
+	Accumulator acc;
+	ThreadPool& pool = ThreadPool::instance();
+	auto accumulate = [summands,factors]( Accumulator& part, std::size_t start, std::size_t end)
+	{
+		for (std::size_t ii = start; ii < end; ++ii)
+		{
+			if (factors)
+			{
+				part.add( summands[ ii]->mul( *factors[ ii]));
+			}
+			else
+			{
+				part.add( *summands[ ii]);
+			}
+		}
+		part.normalize();
+	};
+	std::size_t minParallel = factors ? ParallelMinFactors : ParallelMinSummands;
+	if (!reference_mode() && pool.nofThreads() > 1 && nofSummands >= minParallel)
+	{
+		std::size_t nofChunks = pool.nofThreads() * ParallelChunksPerThread;
+		std::vector<Accumulator> parts( nofChunks);
+		std::vector<ThreadPool::Task> tasks;
+		tasks.reserve( nofChunks);
+		for (std::size_t ci = 0; ci < nofChunks; ++ci)
+		{
+			std::size_t start = ci * nofSummands / nofChunks;
+			std::size_t end = (ci+1) * nofSummands / nofChunks;
+			tasks.push_back( [&parts,&accumulate,ci,start,end]{ accumulate( parts[ ci], start, end); });
+		}
+		pool.run( tasks);
+		for (auto const& part : parts)
+		{
+			acc.add( part);
+		}
+	}
+	else
+	{
+		accumulate( acc, 0, nofSummands);
+	}
+	acc.get( rt);
+}
+
+BigInt BigInt::sum( const std::vector<const BigInt*>& summands)
+{
+	BCD_STATISTICS_SCOPE( OpSum, summands.size());
+	BigInt rt;
+	digits_sum( rt, summands.data(), nullptr, summands.size());
+	return rt;
+}
+
+BigInt BigInt::sum( const std::vector<const BigInt*>& summands, const std::vector<bool>& negate)
+{
+	BCD_STATISTICS_SCOPE( OpSum, summands.size());
+	if (summands.size() != negate.size()) throw std::runtime_error( "sum with signs of arrays of different size");
+	Accumulator acc;
+	for (std::size_t ii = 0; ii < summands.size(); ++ii)
+	{
+		acc.add( *summands[ ii], negate[ ii]);
+	}
+	BigInt rt;
+	acc.get( rt);
+	return rt;
+}
+
+BigInt BigInt::dot( const std::vector<const BigInt*>& arg1, const std::vector<const BigInt*>& arg2)
+{
+	BCD_STATISTICS_SCOPE( OpDot, arg1.size());
+	if (arg1.size() != arg2.size()) throw std::runtime_error( "dot product of arrays of different size");
+	BigInt rt;
+	digits_sum( rt, arg1.data(), arg2.data(), arg1.size());
+	return rt;
+}
+
+BigInt BigInt::factorial( unsigned long nn)
+{
+	BCD_STATISTICS_SCOPE( OpFactorial, 0);
+	BigInt rt;
+	digits_range_product( rt, 2, (FactorType)nn + 1);
+	return rt;
+}
+
+BigInt BigInt::binomial( unsigned long nn, unsigned long kk)
+{
+	BCD_STATISTICS_SCOPE( OpBinomial, 0);
+	if (kk > nn) return BigInt();
+	if (kk > nn - kk) kk = nn - kk;
+
+	if (kk <= nn / BinomialSieveRatio)
+	{
+		// ... for small kk the factors (nn-kk+1)..nn with the prime factors of kk! divided out, the sieve only goes up to kk
+		FactorType first = nn - kk + 1;
+		std::vector<FactorType> factors( kk);
+		for (unsigned long ii = 0; ii < kk; ++ii)
+		{
+			factors[ ii] = first + ii;
+		}
+		std::vector<bool> composite( kk+1, false);
+		for (unsigned long pp = 2; pp <= kk; ++pp)
+		{
+			if (composite[ pp]) continue;
+			for (unsigned long mm = pp * pp; pp <= kk / pp && mm <= kk; mm += pp)
+			{
+				composite[ mm] = true;
+			}
+			unsigned long exponent = 0;
+			for (unsigned long qq = pp; qq <= kk; qq *= pp)
+			{
+				exponent += kk / qq;
+				if (qq > kk / pp) break;
+			}
+			// ... every multiple of p^i in the window gives one factor p, enough of them exist for the quotient to be an integer
+			for (FactorType qq = pp; exponent; qq *= pp)
+			{
+				for (FactorType mm = (first + qq - 1) / qq * qq; exponent && mm <= nn; mm += qq)
+				{
+					factors[ mm - first] /= pp;
+					--exponent;
+				}
+				if (qq > nn / pp) break;
+			}
+			if (exponent) throw std::logic_error( "failed to divide out the prime factors of the binomial denominator");
+		}
+		BigInt rt;
+		digits_factor_product( rt, factors.data(), factors.size());
+		return rt;
+	}
+	// ... the product of the prime powers p^e dividing (nn over kk), with e = sum of (nn/p^i - kk/p^i - (nn-kk)/p^i)
+	std::vector<bool> composite( nn+1, false);
+	std::vector<FactorType> factors;
+	for (unsigned long pp = 2; pp <= nn; ++pp)
+	{
+		if (composite[ pp]) continue;
+		for (unsigned long mm = pp * pp; pp <= nn / pp && mm <= nn; mm += pp)
+		{
+			composite[ mm] = true;
+		}
+		FactorType power = 1;
+		for (unsigned long qq = pp; qq <= nn; qq *= pp)
+		{
+			if (nn / qq - kk / qq - (nn - kk) / qq) power *= pp;
+			if (qq > nn / pp) break;
+		}
+		if (power > 1) factors.push_back( power);
+	}
+	BigInt rt;
+	digits_factor_product( rt, factors.data(), factors.size());
+	return rt;
+}
+
+BigInt BigInt::product( const std::vector<const BigInt*>& factors)
+{
+	BCD_STATISTICS_SCOPE( OpProduct, factors.size());
+	BigInt rt;
+	digits_product( rt, factors.data(), factors.size());
+	return rt;
+}
+
+BigInt BigInt::product( const std::vector<BigInt>& factors)
+{
+	std::vector<const BigInt*> ptrs;
+	ptrs.reserve( factors.size());
+	for (auto const& factor : factors)
+	{
+		ptrs.push_back( &factor);
+	}
+	return product( ptrs);
+}
+
 std::vector<BigInt> BigInt::getBitValues( int nofBits)
 {
 	std::vector<BigInt> rt;
 	rt.reserve( nofBits);
-	rt.push_back( BigInt( "1", 1));
+	rt.push_back( 1_bcd);
 	if (nofBits > 0)
 	{
 		for (int bi=0; bi < nofBits; ++bi)
@@ -1237,7 +2536,7 @@ static BigInt bitwise_op( const BigInt& opr1, const BigInt& opr2, BitwiseOp op,
 	{
 		throw std::runtime_error("Bitwise logical operators not permitted on negative numbers");
 	}
-	BigInt rt( "0", 1);
+	BigInt rt = 0_bcd;
 
 	std::size_t nofBits1 = (0.5 + (opr1.nof_digits() * 3.3219281)) /* estimate bigger than maximum */;
 	std::size_t nofBits2 = (0.5 + (opr2.nof_digits() * 3.3219281)) /* estimate bigger than maximum */;
@@ -1283,26 +2582,30 @@ static BigInt bitwise_op( const BigInt& opr1, const BigInt& opr2, BitwiseOp op,
 
 BigInt BigInt::bitwise_and( const BigInt& opr, const std::vector<BigInt>& bitvalues) const
 {
+	BCD_STATISTICS_SCOPE( OpBitAnd, std::max( m_size, opr.m_size));
 	return bitwise_op( *this, opr, &BitwiseOp_AND, bitvalues);
 }
 
 BigInt BigInt::bitwise_or( const BigInt& opr, const std::vector<BigInt>& bitvalues) const
 {
+	BCD_STATISTICS_SCOPE( OpBitOr, std::max( m_size, opr.m_size));
 	return bitwise_op( *this, opr, &BitwiseOp_OR, bitvalues);
 }
 
 BigInt BigInt::bitwise_xor( const BigInt& opr, const std::vector<BigInt>& bitvalues) const
 {
+	BCD_STATISTICS_SCOPE( OpBitXor, std::max( m_size, opr.m_size));
 	return bitwise_op( *this, opr, &BitwiseOp_XOR, bitvalues);
 }
 
 BigInt BigInt::bitwise_not( const std::vector<BigInt>& bitvalues) const
 {
+	BCD_STATISTICS_SCOPE( OpBitNot, m_size);
 	if (sign() == '-' && !isNull())
 	{
 		throw std::runtime_error("Bitwise logical operators not permitted on negative numbers");
 	}
-	BigInt rt( "0", 1);
+	BigInt rt = 0_bcd;
 	std::size_t nofBits = 0.5 + (nof_digits() * 3.3219281) /* estimate bigger than maximum */;
 
 	if (bitvalues.empty()) return rt;
@@ -1335,3 +2638,321 @@ BigInt BigInt::bitwise_not( const std::vector<BigInt>& bitvalues) const
 	return rt;
 }
 
+static bool is_negative_tencomp( BigInt::Element top) noexcept
+{
+	return ((top >> (NumHighShift-4)) & 0xf) >= 5;
+}
+
+template <class OperandA, class OperandB>
+static void vector_addition( BigInt::Element* rt, OperandA aa, OperandB bb, std::size_t size, unsigned int width, BigInt::Element initcarry)
+{
+	// ... no branches in the inner loop, the carries of all numbers are propagated together element by element
+	std::vector<BigInt::Element> carry( size, initcarry);
+	for (unsigned int jj = 0; jj < width; ++jj)
+	{
+		BigInt::Element* rr = rt + jj * size;
+		for (std::size_t ii = 0; ii < size; ++ii)
+		{
+			BigInt::Element res = add_bcd( add_bcd( aa( jj, ii), bb( jj, ii)), carry[ ii]);
+			carry[ ii] = res >> NumHighShift;
+			rr[ ii] = res & NumMask;
+		}
+	}
+}
+
+static void check_vector_overflow( const BigInt::Element* atop, const BigInt::Element* btop, bool bsign, const BigInt::Element* rtop, std::size_t size, bool subtract)
+{
+	bool overflow = false;
+	for (std::size_t ii = 0; ii < size; ++ii)
+	{
+		bool sa = is_negative_tencomp( atop[ ii]);
+		bool sb = btop ? is_negative_tencomp( btop[ ii]) : bsign;
+		bool sr = is_negative_tencomp( rtop[ ii]);
+		overflow |= ((sa == sb) != subtract) & (sr != sa);
+	}
+	if (overflow) throw std::runtime_error( "overflow in bcd vector operation");
+}
+
+BigIntVector::BigIntVector( std::size_t size_, unsigned int nofDigits)
+	:m_size(size_),m_width(nofDigits / NumDigits + 1),m_ar(m_size * m_width, 0)
+{}
+
+BigIntVector::BigIntVector( const BigIntVector& o)
+	:m_size(o.m_size),m_width(o.m_width),m_ar(o.m_ar)
+{}
+
+BigIntVector::BigIntVector( BigIntVector&& o) noexcept
+	:m_size(o.m_size),m_width(o.m_width),m_ar(std::move(o.m_ar))
+{
+	o.m_size = 0;
+}
+
+BigIntVector& BigIntVector::operator=( const BigIntVector& o)
+{
+	m_size = o.m_size;
+	m_width = o.m_width;
+	m_ar = o.m_ar;
+	return *this;
+}
+
+unsigned int BigIntVector::nof_digits() const noexcept
+{
+	return m_width * NumDigits - 1;
+}
+
+bool BigIntVector::negative( std::size_t idx) const noexcept
+{
+	return is_negative_tencomp( row( m_width-1)[ idx]);
+}
+
+void BigIntVector::tencomp( std::vector<Element>& ar, unsigned int width_, const BigInt& val)
+{
+	if (val.m_size > width_) throw std::runtime_error( "number does not fit into the width of the bcd vector");
+	ar.assign( width_, 0);
+	if (val.m_size) std::memcpy( ar.data(), val.m_ar, val.m_size * sizeof(Element));
+	if (is_negative_tencomp( ar[ width_-1])) throw std::runtime_error( "number does not fit into the width of the bcd vector");
+	if (val.m_sign)
+	{
+		Element carry = 1;
+		for (unsigned int jj = 0; jj < width_; ++jj)
+		{
+			Element res = add_bcd( NinesMask - ar[ jj], carry);
+			carry = res >> NumHighShift;
+			ar[ jj] = res & NumMask;
+		}
+	}
+}
+
+BigInt BigIntVector::get( std::size_t idx) const
+{
+	if (idx >= m_size) throw std::runtime_error( "array bound read in bcd vector");
+	BigInt rt;
+	rt.allocate( m_width);
+	bool sign = negative( idx);
+	Element carry = 1;
+	for (unsigned int jj = 0; jj < m_width; ++jj)
+	{
+		Element val = row( jj)[ idx];
+		if (sign)
+		{
+			val = add_bcd( NinesMask - val, carry);
+			carry = val >> NumHighShift;
+			val &= NumMask;
+		}
+		rt.m_ar[ jj] = val;
+	}
+	rt.m_sign = sign;
+	rt.normalize();
+	return rt;
+}
+
+void BigIntVector::set( std::size_t idx, const BigInt& val)
+{
+	if (idx >= m_size) throw std::runtime_error( "array bound write in bcd vector");
+	std::vector<Element> ar;
+	tencomp( ar, m_width, val);
+	for (unsigned int jj = 0; jj < m_width; ++jj)
+	{
+		m_ar[ jj * m_size + idx] = ar[ jj];
+	}
+}
+
+BigIntVector BigIntVector::widen( unsigned int width_) const
+{
+	BigIntVector rt( m_size, width_ * NumDigits - 1);
+	std::copy( m_ar.begin(), m_ar.end(), rt.m_ar.begin());
+	for (unsigned int jj = m_width; jj < width_; ++jj)
+	{
+		for (std::size_t ii = 0; ii < m_size; ++ii)
+		{
+			rt.m_ar[ jj * m_size + ii] = negative( ii) ? NinesMask : 0;
+		}
+	}
+	return rt;
+}
+
+BigIntVector BigIntVector::addition( const BigIntVector& opr, bool subtract) const
+{
+	if (m_size != opr.m_size) throw std::runtime_error( "operation on bcd vectors of different size");
+	if (m_width < opr.m_width) return widen( opr.m_width).addition( opr, subtract);
+	if (m_width > opr.m_width) return addition( opr.widen( m_width), subtract);
+
+	BigIntVector rt( m_size, nof_digits());
+	const Element* ap = m_ar.data();
+	const Element* bp = opr.m_ar.data();
+	std::size_t size = m_size;
+	auto aa = [ap,size]( unsigned int jj, std::size_t ii){return ap[ jj * size + ii];};
+	if (subtract)
+	{
+		vector_addition( rt.m_ar.data(), aa, [bp,size]( unsigned int jj, std::size_t ii){return NinesMask - bp[ jj * size + ii];}, m_size, m_width, 1);
+	}
+	else
+	{
+		vector_addition( rt.m_ar.data(), aa, [bp,size]( unsigned int jj, std::size_t ii){return bp[ jj * size + ii];}, m_size, m_width, 0);
+	}
+	check_vector_overflow( row( m_width-1), opr.row( m_width-1), false, rt.row( m_width-1), m_size, subtract);
+	return rt;
+}
+
+BigIntVector BigIntVector::addition( const BigInt& opr, bool subtract) const
+{
+	if (opr.m_size >= m_width) return widen( opr.m_size + 1).addition( opr, subtract);
+
+	std::vector<Element> scalar;
+	tencomp( scalar, m_width, opr);
+	const Element* ap = m_ar.data();
+	const Element* sp = scalar.data();
+	std::size_t size = m_size;
+	BigIntVector rt( m_size, nof_digits());
+	auto aa = [ap,size]( unsigned int jj, std::size_t ii){return ap[ jj * size + ii];};
+	if (subtract)
+	{
+		vector_addition( rt.m_ar.data(), aa, [sp]( unsigned int jj, std::size_t){return NinesMask - sp[ jj];}, m_size, m_width, 1);
+	}
+	else
+	{
+		vector_addition( rt.m_ar.data(), aa, [sp]( unsigned int jj, std::size_t){return sp[ jj];}, m_size, m_width, 0);
+	}
+	check_vector_overflow( row( m_width-1), nullptr, is_negative_tencomp( scalar[ m_width-1]), rt.row( m_width-1), m_size, subtract);
+	return rt;
+}
+
+BigIntVector BigIntVector::add( const BigIntVector& opr) const
+{
+	return addition( opr, false);
+}
+
+BigIntVector BigIntVector::add( const BigInt& opr) const
+{
+	return addition( opr, false);
+}
+
+BigIntVector BigIntVector::sub( const BigIntVector& opr) const
+{
+	return addition( opr, true);
+}
+
+BigIntVector BigIntVector::sub( const BigInt& opr) const
+{
+	return addition( opr, true);
+}
+
+BigIntVector BigIntVector::neg() const
+{
+	BigIntVector rt( m_size, nof_digits());
+	const Element* ap = m_ar.data();
+	std::size_t size = m_size;
+	vector_addition( rt.m_ar.data(),
+			[]( unsigned int, std::size_t){return (Element)0;},
+			[ap,size]( unsigned int jj, std::size_t ii){return NinesMask - ap[ jj * size + ii];},
+			m_size, m_width, 1);
+	// ... only the negation of the smallest negative number overflows
+	bool overflow = false;
+	for (std::size_t ii = 0; ii < m_size; ++ii)
+	{
+		overflow |= negative( ii) & rt.negative( ii);
+	}
+	if (overflow) throw std::runtime_error( "overflow in bcd vector operation");
+	return rt;
+}
+
+BigIntVector BigIntVector::scalar_multiplication( unsigned int factor) const
+{
+	// ... multiplication of the ten's complement modulo 10^(width*NumDigits), the carry out of
+	//	a negative number multiplied with factor has to be factor-1 if there is no overflow
+	BigIntVector rt( m_size, nof_digits());
+	std::vector<std::uint64_t> carry( m_size, 0);
+	for (unsigned int jj = 0; jj < m_width; ++jj)
+	{
+		const Element* ar = row( jj);
+		Element* rr = rt.m_ar.data() + jj * m_size;
+		for (std::size_t ii = 0; ii < m_size; ++ii)
+		{
+			std::uint64_t val = bcd_to_uint( ar[ ii]) * factor + carry[ ii];
+			carry[ ii] = val / ElementBase;
+			rr[ ii] = uint_to_bcd( val % ElementBase);
+		}
+	}
+	bool overflow = false;
+	for (std::size_t ii = 0; ii < m_size; ++ii)
+	{
+		bool sa = negative( ii);
+		overflow |= (sa != rt.negative( ii)) | (carry[ ii] != (sa ? factor-1 : 0));
+	}
+	if (overflow) throw std::runtime_error( "overflow in bcd vector operation");
+	return rt;
+}
+
+BigIntVector BigIntVector::mul( const BigInt& opr) const
+{
+	if (opr.isNull()) return BigIntVector( m_size, nof_digits());
+	if (opr.m_size == 1 && bcd_to_uint( opr.m_ar[ 0]) < MaxVectorScalarFactor)
+	{
+		BigIntVector rt = scalar_multiplication( bcd_to_uint( opr.m_ar[ 0]));
+		return opr.m_sign ? rt.neg() : rt;
+	}
+	BigIntVector rt( m_size, nof_digits());
+	for (std::size_t ii = 0; ii < m_size; ++ii)
+	{
+		rt.set( ii, get( ii).mul( opr));
+	}
+	return rt;
+}
+
+BigIntVector BigIntVector::mul( const BigIntVector& opr) const
+{
+	if (m_size != opr.m_size) throw std::runtime_error( "operation on bcd vectors of different size");
+	BigIntVector rt( m_size, std::max( m_width, opr.m_width) * NumDigits - 1);
+	for (std::size_t ii = 0; ii < m_size; ++ii)
+	{
+		rt.set( ii, get( ii).mul( opr.get( ii)));
+	}
+	return rt;
+}
+
+template <class OperandB>
+static void vector_compare( std::vector<int>& rt, const BigInt::Element* ap, OperandB bb, std::size_t size, unsigned int width)
+{
+	// ... the highest element is compared with the negative numbers shifted below the positive ones
+	rt.assign( size, 0);
+	for (unsigned int jj = width; jj > 0; --jj)
+	{
+		const BigInt::Element* ar = ap + (jj-1) * size;
+		for (std::size_t ii = 0; ii < size; ++ii)
+		{
+			std::uint64_t aval = ar[ ii], bval = bb( jj-1, ii);
+			if (jj == width)
+			{
+				aval = (bcd_to_uint( aval) + NegativeBias) % ElementBase;
+				bval = (bcd_to_uint( bval) + NegativeBias) % ElementBase;
+			}
+			int cmp = (aval > bval) - (aval < bval);
+			rt[ ii] = rt[ ii] ? rt[ ii] : cmp;
+		}
+	}
+}
+
+std::vector<int> BigIntVector::compare( const BigIntVector& opr) const
+{
+	if (m_size != opr.m_size) throw std::runtime_error( "operation on bcd vectors of different size");
+	if (m_width < opr.m_width) return widen( opr.m_width).compare( opr);
+	if (m_width > opr.m_width) return compare( opr.widen( m_width));
+
+	std::vector<int> rt;
+	const Element* bp = opr.m_ar.data();
+	std::size_t size = m_size;
+	vector_compare( rt, m_ar.data(), [bp,size]( unsigned int jj, std::size_t ii){return bp[ jj * size + ii];}, m_size, m_width);
+	return rt;
+}
+
+std::vector<int> BigIntVector::compare( const BigInt& opr) const
+{
+	if (opr.m_size >= m_width) return widen( opr.m_size + 1).compare( opr);
+
+	std::vector<int> rt;
+	std::vector<Element> scalar;
+	tencomp( scalar, m_width, opr);
+	const Element* sp = scalar.data();
+	vector_compare( rt, m_ar.data(), [sp]( unsigned int jj, std::size_t){return sp[ jj];}, m_size, m_width);
+	return rt;
+}
@@ -14,7 +14,12 @@
 #define _BCD_ARITHMETIC_HPP_INCLUDED
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <utility>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 
 namespace bcd {
 
@@ -52,6 +57,7 @@ private:
 
 ///\class BigInt
 ///\brief Arbitrary size BCD number type with basic arithmetic operations
+///\note Copies share the allocated elements (reference counted), an operation assigning a number gives it new elements if they are shared
 class BigInt
 {
 public:
@@ -92,14 +98,117 @@ public:
 	BigInt operator -() const					{return neg();}
 
 	BigInt add( const BigInt& opr) const;
+	BigInt add( long opr) const;
 	BigInt sub( const BigInt& opr) const;
+	BigInt sub( long opr) const;
 	BigInt mul( FactorType opr) const;
 	BigInt mul( long opr) const;
 	BigInt mul( const BigInt& opr) const;
 	std::pair<BigInt,BigInt> div( const BigInt& opr) const;
+	//\brief Division by a machine integer without temporary number for the divisor
+	//\return the pair (quotient,remainder), the remainder is not negative
+	std::pair<BigInt,BigInt> div( long opr) const;
 	BigInt mod( const BigInt& opr) const;
+	BigInt mod( long opr) const;
 	BigInt neg() const;
 	BigInt pow( unsigned long opr) const;
+	//\brief Integer square root
+	//\return the pair (root,remainder) with root*root + remainder == *this
+	std::pair<BigInt,BigInt> isqrt() const;
+	//\brief Integer n-th root
+	//\return the pair (root,remainder) with root^nn + remainder == *this
+	std::pair<BigInt,BigInt> iroot( unsigned int nn) const;
+
+	//\brief Factorial nn!
+	static BigInt factorial( unsigned long nn);
+	//\brief Binomial coefficient (nn over kk)
+	static BigInt binomial( unsigned long nn, unsigned long kk);
+	//\brief Product of a list of numbers, evaluated as balanced product tree
+	static BigInt product( const std::vector<const BigInt*>& factors);
+	static BigInt product( const std::vector<BigInt>& factors);
+	//\brief Sum of a list of numbers, accumulated with deferred carry normalization
+	static BigInt sum( const std::vector<const BigInt*>& summands);
+	//\brief Sum of a list of numbers with the summands flagged in negate subtracted, accumulated with one carry normalization
+	static BigInt sum( const std::vector<const BigInt*>& summands, const std::vector<bool>& negate);
+	//\brief Sum of the pairwise products of the elements of two lists of equal size
+	static BigInt dot( const std::vector<const BigInt*>& arg1, const std::vector<const BigInt*>& arg2);
+
+	//\brief Set the number of threads used for operations on very large numbers
+	//\note The threads are shared by all threads of the process, the call waits for the parallel operations in process to complete
+	//\param[in] nofThreads number of threads, 0 or 1 for single threaded operation
+	static void setNofThreads( unsigned int nofThreads);
+	//\brief Set the minimum size of the operands of a multiplication processed in parallel
+	//\param[in] nofDigits minimum of the geometric mean of the number of digits of the operands
+	static void setParallelThreshold( std::size_t nofDigits);
+	//\brief Let all operations skip their fast paths and use only the reference algorithms, for cross checking the fast paths
+	//\note Global for all threads, for testing only
+	static void setReferenceMode( bool enabled) noexcept;
+	//\brief Tell if the operations use only the reference algorithms
+	static bool referenceMode() noexcept;
+
+	//\brief Function allocating (nsize > 0) or freeing (nsize == 0) the elements of numbers, same signature as lua_Alloc
+	typedef void* (*AllocFunction)( void* ctx, void* ptr, std::size_t osize, std::size_t nsize);
+	//\brief Set the function allocating the elements of numbers, nullptr for std::malloc and std::free
+	//\note Must be set before numbers are allocated and must be thread safe if more than one thread is used
+	static void setAllocator( AllocFunction func, void* ctx) noexcept;
+	//\brief Get the number of bytes currently allocated for the elements of numbers
+	static std::size_t memoryInUse() noexcept;
+	//\brief Get the number of bytes allocated for the elements of numbers since the start of the program
+	static std::size_t memoryAllocated() noexcept;
+	//\brief Free the elements of this number, leaving it zero
+	void release() noexcept;
+
+	enum {NofSizeClasses = 32};
+	//\brief Statistics of an operation summed up over all threads
+	struct OperationStatistics
+	{
+		const char* name;
+		std::uint64_t count;
+		std::uint64_t nanoseconds;
+		std::uint64_t allocations;
+		std::uint64_t allocatedBytes;
+		//\brief Number of calls by size of the biggest operand in elements, 0 in sizes[0], [2^(i-1),2^i-1] in sizes[i]
+		std::uint64_t sizes[ NofSizeClasses];
+	};
+	//\brief Get the statistics of the public operations, operations called by others are counted too
+	//\note Only collected if built with BCD_STATISTICS defined, empty otherwise
+	static std::vector<OperationStatistics> statistics();
+	//\brief Reset the statistics of all threads
+	static void resetStatistics();
+
+	//\brief Create a number referencing constant elements without owning them
+	//\note The elements must stay valid during the lifetime of the number, copies of the number own their elements
+	static BigInt constant( const Element* ar, std::size_t size, bool sign=false) noexcept;
+	//\brief Get the size in bytes of the serialization of the number
+	std::size_t serialized_size() const noexcept;
+	//\brief Write the serialization of the number: a header of 16 bytes ('B','C', version, flags (1 = negative), 4 reserved zero bytes, number of elements as 64 bit word) followed by the elements, all words little endian
+	//\param[out] buf buffer of serialized_size() bytes
+	void serialize( void* buf) const noexcept;
+	std::string serialize() const;
+	//\brief Get the number of a serialization, validated
+	//\note References the elements in the buffer without copy if they are aligned on a little endian machine, the buffer must stay valid during the lifetime of the result then, copies of the result own their elements
+	static BigInt deserialize( const void* buf, std::size_t bufsize);
+	//\brief Make the number zero and let it use writable storage for its elements without owning it
+	//\note Results not fitting into the storage are allocated on the heap, the storage must stay valid during the lifetime of the number
+	void attach( Element* storage, std::size_t capacity) noexcept;
+
+	//\brief Evaluate an operation into the storage of this number, that must not be one of the operands
+	void assign_add( const BigInt& this_, const BigInt& opr);
+	void assign_add( const BigInt& this_, long opr);
+	void assign_sub( const BigInt& this_, const BigInt& opr);
+	void assign_sub( const BigInt& this_, long opr);
+	void assign_mul( const BigInt& this_, const BigInt& opr);
+	void assign_mul( const BigInt& this_, long opr);
+	void assign_mod( const BigInt& this_, const BigInt& opr);
+	void assign_mod( const BigInt& this_, long opr);
+
+	//\brief Get the number of elements to reserve for the result of an operation with this number as first operand
+	std::size_t add_capacity( const BigInt& opr) const noexcept	{return std::max( m_size, opr.m_size) + 1;}
+	std::size_t add_capacity( long) const noexcept			{return std::max( m_size, (std::size_t)2) + 1;}
+	std::size_t mul_capacity( const BigInt& opr) const noexcept	{return m_size + opr.m_size + 1;}
+	std::size_t mul_capacity( long) const noexcept			{return m_size + 2;}
+	std::size_t mod_capacity( const BigInt& opr) const noexcept	{return opr.m_size;}
+	std::size_t mod_capacity( long) const noexcept			{return 2;}
 
 	//\brief Get Values of bits needed for bitwise operations
 	static std::vector<BigInt> getBitValues( int nofBits);
@@ -120,7 +229,7 @@ public:
 	BigInt cut( unsigned int digits) const;
 	BigInt round( const BigInt& gran) const;
 
-	void invert_sign()					{m_sign = !m_sign; normalize();}
+	void invert_sign() noexcept				{m_sign = !m_sign && m_size;}
 	char sign() const noexcept				{return m_sign?'-':'+';}
 
 	bool operator==( const BigInt& o) const noexcept	{return compare(o)==0;}
@@ -130,16 +239,24 @@ public:
 	bool operator>=( const BigInt& o) const noexcept	{return compare(o)>=0;}
 	bool operator>( const BigInt& o) const noexcept		{return compare(o)>0;}
 	int compare( const BigInt& o) const noexcept;
+	int compare( long o) const noexcept;
 
 	bool cmpeq( const BigInt& o) const noexcept		{return compare(o)==0;}
 	bool cmple( const BigInt& o) const noexcept		{return compare(o)<=0;}
 	bool cmplt( const BigInt& o) const noexcept		{return compare(o)<0;}
+	bool cmpeq( long o) const noexcept			{return compare(o)==0;}
+	bool cmple( long o) const noexcept			{return compare(o)<=0;}
+	bool cmplt( long o) const noexcept			{return compare(o)<0;}
 
 	bool isValid() const noexcept;
 	bool isNull() const noexcept;
-	std::size_t nof_digits() const noexcept			{return begin().size();}
+	std::size_t nof_digits() const noexcept			{return m_nofDigits;}
+	std::size_t nof_elements() const noexcept		{return m_size;}
+	const Element* elements() const noexcept		{return m_ar;}
 
 	friend class const_iterator;
+	friend class BigIntVector;
+	template <unsigned int> friend class FixedBigInt;
 	class const_iterator
 	{
 	public:
@@ -176,28 +293,470 @@ public:
 	const_iterator end() const noexcept				{return const_iterator();}
 
 private:
+	BigInt( Element* ar, std::size_t size_, bool sign_) noexcept
+		:m_size(size_),m_capacity(0),m_ar(ar),m_sign(sign_ && size_),m_allocated(false),m_nofDigits(count_digits( ar, size_)){}
 	void allocate( std::size_t size_);
+	void init_digits( const char* digits, std::size_t nofDigits, bool sign);
+	bool native_value( long& val) const noexcept;
+	void assign_native( long val);
 	void copy( const BigInt& o);
+	void share( const BigInt& o) noexcept;
+	void release_elements() noexcept;
+	bool shared() const noexcept;
 	void normalize();
+	static std::size_t count_digits( const Element* ar, std::size_t size) noexcept;
 
 	static void digits_addition( BigInt& dest, const BigInt& this_, const BigInt& opr);
 	static void digits_subtraction( BigInt& dest, const BigInt& this_, const BigInt& opr);
 	static void digits_shift( BigInt& dest, const BigInt& this_, int nof_digits);
 	static void digits_cut( BigInt& dest, const BigInt& this_, unsigned int nof_digits);
 	static void digits_nibble_multiplication( BigInt& dest, const BigInt& this_, unsigned char factor);
-	static void digits_16_multiplication( BigInt& dest, const BigInt& this_);
 	static void digits_multiplication( BigInt& dest, const BigInt& this_, FactorType factor);
 	static void digits_multiplication( BigInt& dest, const BigInt& this_, const BigInt& factor);
+	static void digits_parallel_multiplication( BigInt& dest, const BigInt& this_, const BigInt& factor);
+	static bool use_parallel_multiplication( const BigInt& this_, const BigInt& factor) noexcept;
 	static void digits_division( BigInt& result, BigInt& remainder, const BigInt& this_, const BigInt& factor);
 	static FactorType division_estimate( const BigInt& this_, const BigInt& opr) noexcept;
 	static BigInt estimate_as_bcd( FactorType estimate, int estshift);
+	static BigInt root_upper_bound( const BigInt& this_, unsigned int nn);
+	static void digits_root( BigInt& result, BigInt& remainder, const BigInt& this_, unsigned int nn);
+	static void digits_range_product( BigInt& result, FactorType from, FactorType to);
+	static void digits_factor_product( BigInt& result, const FactorType* factors, std::size_t nofFactors);
+	static void digits_product( BigInt& result, const BigInt* const* factors, std::size_t nofFactors);
+	static void digits_sequential_product( BigInt& result, const BigInt* const* factors, std::size_t nofFactors);
+	static void digits_sum( BigInt& result, const BigInt* const* summands, const BigInt* const* factors, std::size_t nofSummands);
+	template <unsigned int N>
+	static void small_addition( BigInt& dest, const BigInt& this_, const BigInt& opr, bool subtract);
+	template <unsigned int N>
+	static void small_multiplication( BigInt& dest, const BigInt& this_, const BigInt& opr);
+	template <unsigned int N>
+	static int small_compare( const BigInt& this_, const BigInt& opr) noexcept;
+	void trim() noexcept;
+	static std::uint64_t digits_short_division( BigInt* result, const BigInt& this_, std::uint64_t divisor);
+
+	struct Accumulator;
 
 private:
 	std::size_t m_size;
+	std::size_t m_capacity;
 	Element* m_ar;
 	bool m_sign;
 	bool m_allocated;
+	std::size_t m_nofDigits;	///< number of digits without leading zeros, updated by normalize and trim
+};
+
+
+///\class BigIntVector
+///\brief Vector of fixed width BCD numbers with element wise arithmetic operations
+///\note The numbers are stored as ten's complement, the elements of the same significance of all numbers contiguously
+class BigIntVector
+{
+public:
+	typedef BigInt::Element Element;
+
+	/// \brief Constructor
+	/// \param[in] size_ number of numbers, initialized with 0
+	/// \param[in] nofDigits minimum number of digits of the numbers (without sign)
+	BigIntVector( std::size_t size_, unsigned int nofDigits);
+	BigIntVector( const BigIntVector& o);
+	BigIntVector( BigIntVector&& o) noexcept;
+	BigIntVector& operator=( const BigIntVector& o);
+
+	/// \brief Get the number of numbers in the vector
+	std::size_t size() const noexcept			{return m_size;}
+	/// \brief Get the maximum number of digits of a number in the vector
+	unsigned int nof_digits() const noexcept;
+
+	/// \brief Get the number at index idx
+	BigInt get( std::size_t idx) const;
+	/// \brief Set the number at index idx
+	/// \note Throws if the number does not fit into the width of the vector
+	void set( std::size_t idx, const BigInt& val);
+
+	/// \note The arithmetic operations throw on overflow of the width of the result
+	BigIntVector add( const BigIntVector& opr) const;
+	BigIntVector add( const BigInt& opr) const;
+	BigIntVector sub( const BigIntVector& opr) const;
+	BigIntVector sub( const BigInt& opr) const;
+	BigIntVector mul( const BigIntVector& opr) const;
+	BigIntVector mul( const BigInt& opr) const;
+	BigIntVector neg() const;
+
+	/// \brief Compare the numbers element wise
+	/// \return the list of comparison results, -1 if smaller, 0 if equal, +1 if greater than opr
+	std::vector<int> compare( const BigIntVector& opr) const;
+	std::vector<int> compare( const BigInt& opr) const;
+
+private:
+	BigIntVector widen( unsigned int width_) const;
+	BigIntVector addition( const BigIntVector& opr, bool subtract) const;
+	BigIntVector addition( const BigInt& opr, bool subtract) const;
+	BigIntVector scalar_multiplication( unsigned int factor) const;
+	bool negative( std::size_t idx) const noexcept;
+	const Element* row( unsigned int jj) const noexcept	{return m_ar.data() + jj * m_size;}
+	static void tencomp( std::vector<Element>& ar, unsigned int width_, const BigInt& val);
+
+private:
+	std::size_t m_size;		///< number of numbers
+	unsigned int m_width;		///< number of elements of a number
+	std::vector<Element> m_ar;	///< element jj of number ii at m_ar[ jj*m_size + ii]
 };
 
+//\brief Operations on single packed BCD elements, used by the inline templates, not part of the interface
+namespace detail {
+
+inline std::uint64_t checkvalue( std::uint64_t a) noexcept
+{
+	// thanks to http://homepage.divms.uiowa.edu/~jones/bcd/bcd.html:
+	std::uint64_t t1,t2;
+	t1 = a + 0x0666666666666666ULL;
+	t2 = t1 ^ a;
+	return (t2 & 0x1111111111111110ULL);
+}
+
+inline std::uint64_t add_bcd( std::uint64_t a, std::uint64_t b) noexcept
+{
+	// thanks to http://homepage.divms.uiowa.edu/~jones/bcd/bcd.html:
+	std::uint64_t t1,t2,t3,t4,t5,t6;
+	t1 = a + 0x0666666666666666ULL;
+	t2 = t1 + b;
+	t3 = t1 ^ b;
+	t4 = t2 ^ t3;
+	t5 = ~t4 & 0x1111111111111110ULL;
+	t6 = (t5 >> 2) | (t5 >> 3);
+	return t2 - t6;
+}
+
+inline std::uint64_t bcd_to_uint( std::uint64_t a) noexcept
+{
+	// ... combine the digits pairwise to bytes, 16 bit and 32 bit lanes in parallel:
+	std::uint64_t t1,t2,t3;
+	t1 = (a & 0x0f0f0f0f0f0f0f0fULL) + ((a >> 4) & 0x0f0f0f0f0f0f0f0fULL) * 10;
+	t2 = (t1 & 0x00ff00ff00ff00ffULL) + ((t1 >> 8) & 0x00ff00ff00ff00ffULL) * 100;
+	t3 = (t2 & 0x0000ffff0000ffffULL) + ((t2 >> 16) & 0x0000ffff0000ffffULL) * 10000;
+	return (t3 & 0x00000000ffffffffULL) + (t3 >> 32) * 100000000ULL;
+}
+
+inline std::uint64_t uint_to_bcd_groups( std::uint64_t w) noexcept
+{
+	// ... two 32 bit lanes with a group of 4 digits each, split into pairs in 16 bit lanes and into digits, divisions as multiplications exact for the ranges
+	std::uint64_t q;
+	q = ((w * 5243) >> 19) & 0x0000007f0000007fULL;
+	w = (w - q * 100) | (q << 16);
+	q = ((w * 103) >> 10) & 0x000f000f000f000fULL;
+	w = (w - q * 10) | (q << 4);
+	return (w & 0x000000ff000000ffULL) | ((w >> 8) & 0x0000ff000000ff00ULL);
+}
+
+inline std::uint64_t uint_to_bcd( std::uint64_t a) noexcept
+{
+	// ... inverse of bcd_to_uint for a < 10^16, the groups of 4 digits are converted in parallel lanes
+	std::uint32_t hi = (std::uint32_t)(a / 100000000ULL), lo = (std::uint32_t)(a % 100000000ULL);
+	std::uint64_t even = ((std::uint64_t)(hi % 10000) << 32) | (lo % 10000);
+	std::uint64_t odd = ((std::uint64_t)(hi / 10000) << 32) | (lo / 10000);
+	return uint_to_bcd_groups( even) | (uint_to_bcd_groups( odd) << 16);
+}
+
+template <class Function, std::size_t... Index>
+inline void unrolled_loop( Function func, std::index_sequence<Index...>)
+{
+	(func( Index), ...);
+}
+
+//\brief Call func( ii) for ii in [0..N) with the loop unrolled at compile time
+template <std::size_t N, class Function>
+inline void unrolled( Function func)
+{
+	unrolled_loop( func, std::make_index_sequence<N>());
+}
+
+}//namespace
+
+///\class FixedBigInt
+///\brief BCD number type of fixed size NumElements*15 digits with the elements stored inline
+///\note Arithmetic operations throw on overflow instead of growing, all element loops are unrolled
+template <unsigned int NumElements>
+class FixedBigInt
+{
+public:
+	typedef BigInt::Element Element;
+	enum {NofDigits = NumElements * 15};
+
+	FixedBigInt() noexcept						:m_sign(false) {detail::unrolled<NumElements>( [this]( std::size_t ii){m_ar[ ii] = 0;});}
+	explicit FixedBigInt( long num)					{init( num);}
+	explicit FixedBigInt( const std::string& numstr)		{init( BigInt( numstr));}
+	explicit FixedBigInt( const BigInt& num)			{init( num);}
+	FixedBigInt( const FixedBigInt& o) noexcept = default;
+	FixedBigInt& operator=( const FixedBigInt& o) noexcept = default;
+
+	void init( long num)
+	{
+		std::uint64_t val = num < 0 ? -(std::uint64_t)num : (std::uint64_t)num;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){m_ar[ ii] = detail::uint_to_bcd( val % Base); val /= Base;});
+		if (val) throw std::runtime_error( "overflow in fixed size bcd number");
+		m_sign = num < 0;
+	}
+	void init( const BigInt& num)
+	{
+		if (num.m_size > NumElements) throw std::runtime_error( "overflow in fixed size bcd number");
+		detail::unrolled<NumElements>( [&]( std::size_t ii){m_ar[ ii] = ii < num.m_size ? num.m_ar[ ii] : 0;});
+		m_sign = num.m_sign;
+	}
+
+	BigInt tobigint() const
+	{
+		BigInt rt;
+		rt.allocate( NumElements);
+		std::memcpy( rt.m_ar, m_ar, sizeof( m_ar));
+		rt.m_sign = m_sign;
+		rt.normalize();
+		return rt;
+	}
+	std::string tostring() const					{return tobigint().tostring();}
+	long toint() const						{return tobigint().toint();}
+	double todouble() const						{return tobigint().todouble();}
+
+	std::pair<FixedBigInt,FixedBigInt> operator /( const FixedBigInt& opr) const	{return div( opr);}
+	FixedBigInt operator *( const FixedBigInt& opr) const		{return mul( opr);}
+	FixedBigInt operator *( long opr) const				{return mul( opr);}
+	FixedBigInt operator %( const FixedBigInt& opr) const		{return mod( opr);}
+	FixedBigInt operator +( const FixedBigInt& opr) const		{return add( opr);}
+	FixedBigInt operator -( const FixedBigInt& opr) const		{return sub( opr);}
+	FixedBigInt operator -() const					{return neg();}
+
+	FixedBigInt add( const FixedBigInt& opr) const			{return addition( opr, false);}
+	FixedBigInt sub( const FixedBigInt& opr) const			{return addition( opr, true);}
+	FixedBigInt neg() const
+	{
+		FixedBigInt rt( *this);
+		rt.m_sign = !m_sign && !isNull();
+		return rt;
+	}
+
+	FixedBigInt mul( const FixedBigInt& opr) const
+	{
+		// ... schoolbook multiplication in binary with base 10^15, the column sums fit into 128 bits
+		std::uint64_t aa[ NumElements], bb[ NumElements];
+		DoubleElement col[ 2*NumElements];
+		detail::unrolled<NumElements>( [&]( std::size_t ii){aa[ ii] = detail::bcd_to_uint( m_ar[ ii]); bb[ ii] = detail::bcd_to_uint( opr.m_ar[ ii]);});
+		detail::unrolled<2*NumElements>( [&]( std::size_t kk){col[ kk] = 0;});
+		detail::unrolled<NumElements>( [&]( std::size_t ii){
+			detail::unrolled<NumElements>( [&]( std::size_t jj){col[ ii+jj] += (DoubleElement)aa[ ii] * bb[ jj];});
+		});
+		FixedBigInt rt;
+		DoubleElement carry = 0;
+		bool overflow = false;
+		detail::unrolled<2*NumElements>( [&]( std::size_t kk){
+			carry += col[ kk];
+			Element digits = detail::uint_to_bcd( (std::uint64_t)(carry % Base));
+			carry /= Base;
+			if (kk < NumElements) rt.m_ar[ kk] = digits; else overflow |= (digits != 0);
+		});
+		if (overflow || carry) throw std::runtime_error( "overflow in fixed size bcd number");
+		rt.m_sign = (m_sign != opr.m_sign) && !rt.isNull();
+		return rt;
+	}
+	FixedBigInt mul( long opr) const
+	{
+		std::uint64_t factor = opr < 0 ? -(std::uint64_t)opr : (std::uint64_t)opr;
+		FixedBigInt rt;
+		DoubleElement carry = 0;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){
+			carry += (DoubleElement)detail::bcd_to_uint( m_ar[ ii]) * factor;
+			rt.m_ar[ ii] = detail::uint_to_bcd( (std::uint64_t)(carry % Base));
+			carry /= Base;
+		});
+		if (carry) throw std::runtime_error( "overflow in fixed size bcd number");
+		rt.m_sign = (m_sign != (opr < 0)) && !rt.isNull();
+		return rt;
+	}
+
+	//\note Same semantics as BigInt::div, the remainder is not negative
+	std::pair<FixedBigInt,FixedBigInt> div( const FixedBigInt& opr) const
+	{
+		if (opr.isNull()) throw std::runtime_error( "division by zero");
+		// ... long division digit by digit, the quotient digit found by repeated subtraction
+		std::pair<FixedBigInt,FixedBigInt> rt;
+		Element* quo = rt.first.m_ar;
+		Element* rem = rt.second.m_ar;
+		for (unsigned int ei = NumElements; ei > 0; --ei)
+		{
+			for (int shf = 56; shf >= 0; shf -= 4)
+			{
+				// ... the digit shifted out of the remainder is kept in 'high'
+				Element high = rem[ NumElements-1] >> 56;
+				Element digit = (m_ar[ ei-1] >> shf) & 0xf;
+				detail::unrolled<NumElements>( [&]( std::size_t ii){
+					std::size_t kk = NumElements-1-ii;
+					rem[ kk] = ((rem[ kk] << 4) & Mask) | (kk ? (rem[ kk-1] >> 56) : digit);
+				});
+				Element qq = 0;
+				while (high || compare_magnitude( rem, opr.m_ar) >= 0)
+				{
+					high -= 1 - subtract_magnitude( rem, rem, opr.m_ar);
+					++qq;
+				}
+				quo[ ei-1] |= qq << shf;
+			}
+		}
+		rt.first.m_sign = (m_sign != opr.m_sign) && !rt.first.isNull();
+		return rt;
+	}
+	FixedBigInt mod( const FixedBigInt& opr) const			{return div( opr).second;}
+
+	bool operator==( const FixedBigInt& o) const noexcept		{return compare(o)==0;}
+	bool operator!=( const FixedBigInt& o) const noexcept		{return compare(o)!=0;}
+	bool operator<=( const FixedBigInt& o) const noexcept		{return compare(o)<=0;}
+	bool operator<( const FixedBigInt& o) const noexcept		{return compare(o)<0;}
+	bool operator>=( const FixedBigInt& o) const noexcept		{return compare(o)>=0;}
+	bool operator>( const FixedBigInt& o) const noexcept		{return compare(o)>0;}
+	int compare( const FixedBigInt& o) const noexcept
+	{
+		if (m_sign != o.m_sign) return m_sign ? -1 : +1;
+		int rt = compare_magnitude( m_ar, o.m_ar);
+		return m_sign ? -rt : rt;
+	}
+
+	bool cmpeq( const FixedBigInt& o) const noexcept		{return compare(o)==0;}
+	bool cmple( const FixedBigInt& o) const noexcept		{return compare(o)<=0;}
+	bool cmplt( const FixedBigInt& o) const noexcept		{return compare(o)<0;}
+
+	char sign() const noexcept					{return m_sign?'-':'+';}
+	bool isNull() const noexcept
+	{
+		Element rt = 0;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){rt |= m_ar[ ii];});
+		return rt == 0;
+	}
+	bool isValid() const noexcept
+	{
+		Element chkval = 0;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){chkval |= detail::checkvalue( m_ar[ ii]) | (m_ar[ ii] & ~Mask);});
+		return chkval == 0;
+	}
+
+private:
+	__extension__ typedef unsigned __int128 DoubleElement;
+	static constexpr Element Mask = 0x0fffFFFFffffFFFFULL;
+	static constexpr Element Nines = 0x0999999999999999ULL;
+	static constexpr std::uint64_t Base = 1000000000000000ULL;
+
+	FixedBigInt addition( const FixedBigInt& opr, bool subtract) const
+	{
+		FixedBigInt rt;
+		if ((m_sign == opr.m_sign) != subtract)
+		{
+			if (add_magnitude( rt.m_ar, m_ar, opr.m_ar)) throw std::runtime_error( "overflow in fixed size bcd number");
+			rt.m_sign = m_sign;
+		}
+		else if (subtract_magnitude( rt.m_ar, m_ar, opr.m_ar))
+		{
+			rt.m_sign = m_sign;
+		}
+		else
+		{
+			// ... the result is the ten's complement of the difference
+			Element carry = 1;
+			detail::unrolled<NumElements>( [&]( std::size_t ii){
+				Element res = detail::add_bcd( Nines - rt.m_ar[ ii], carry);
+				carry = res >> 60;
+				rt.m_ar[ ii] = res & Mask;
+			});
+			rt.m_sign = !m_sign;
+		}
+		rt.m_sign &= !rt.isNull();
+		return rt;
+	}
+
+	// ... returns the carry
+	static Element add_magnitude( Element* rt, const Element* aa, const Element* bb) noexcept
+	{
+		Element carry = 0;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){
+			Element res = detail::add_bcd( detail::add_bcd( aa[ ii], bb[ ii]), carry);
+			carry = res >> 60;
+			rt[ ii] = res & Mask;
+		});
+		return carry;
+	}
+	// ... returns 1 if aa >= bb, else 0 with the ten's complement of the difference in rt
+	static Element subtract_magnitude( Element* rt, const Element* aa, const Element* bb) noexcept
+	{
+		Element carry = 1;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){
+			Element res = detail::add_bcd( detail::add_bcd( aa[ ii], Nines - bb[ ii]), carry);
+			carry = res >> 60;
+			rt[ ii] = res & Mask;
+		});
+		return carry;
+	}
+	static int compare_magnitude( const Element* aa, const Element* bb) noexcept
+	{
+		int rt = 0;
+		detail::unrolled<NumElements>( [&]( std::size_t ii){
+			std::size_t kk = NumElements-1-ii;
+			rt = rt ? rt : (aa[ kk] > bb[ kk]) - (aa[ kk] < bb[ kk]);
+		});
+		return rt;
+	}
+
+private:
+	Element m_ar[ NumElements];
+	bool m_sign;
+};
+
+namespace literals {
+
+template <char... Digits>
+struct BcdLiteral
+{
+	static constexpr char digits[ sizeof...(Digits)] = {Digits...};
+
+	static constexpr bool isDecimal()
+	{
+		for (char ch : digits) if ((ch < '0' || ch > '9') && ch != '\'') return false;
+		return true;
+	}
+	static constexpr std::size_t nofDigits()
+	{
+		std::size_t rt = 0;
+		for (char ch : digits) if (ch != '\'' && (rt || ch != '0')) ++rt;
+		return rt;
+	}
+	static constexpr std::size_t size = (nofDigits() + 14) / 15;
+
+	static constexpr std::array<BigInt::Element,(size ? size : 1)> pack()
+	{
+		std::array<BigInt::Element,(size ? size : 1)> rt{};
+		std::size_t ei = 0, shf = 0, di = sizeof...(Digits), dn = nofDigits();
+		for (; di > 0 && dn > 0; --di)
+		{
+			if (digits[ di-1] == '\'') continue;
+			rt[ ei] |= (BigInt::Element)(digits[ di-1] - '0') << shf;
+			--dn;
+			shf += 4;
+			if (shf == 60)
+			{
+				shf = 0;
+				++ei;
+			}
+		}
+		return rt;
+	}
+	static constexpr std::array<BigInt::Element,(size ? size : 1)> elements = pack();
+
+	static_assert( isDecimal(), "only decimal integer literals allowed as BCD literal");
+};
+
+//\brief BCD number literal, e.g. 12345678901234567890_bcd, packed at compile time into static storage
+//\return a number referencing the static elements of the literal without owning them
+template <char... Digits>
+inline BigInt operator""_bcd()
+{
+	return BigInt::constant( BcdLiteral<Digits...>::elements.data(), BcdLiteral<Digits...>::size);
+}
+
+}//namespace
+
 }//namespace
 #endif
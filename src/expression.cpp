@@ -0,0 +1,326 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file expression.cpp
+///\brief Implements the graph of expressions and their compilation and evaluation
+#include "expression.hpp"
+#include <utility>
+#include <stdexcept>
+
+#define MaxSubexpressionString 256
+
+using namespace bcd;
+
+static bool is_operation( ExpressionOp op) noexcept
+{
+	return op != ExpressionOp::Argument && op != ExpressionOp::Constant;
+}
+
+static bool is_sum( ExpressionOp op) noexcept
+{
+	return op == ExpressionOp::Add || op == ExpressionOp::Sub || op == ExpressionOp::Neg;
+}
+
+static int nof_operands( ExpressionOp op) noexcept
+{
+	return is_operation( op) ? (op == ExpressionOp::Neg ? 1 : 2) : 0;
+}
+
+ExpressionGraph::ExpressionGraph( std::size_t nofArguments)
+	:m_nodes(),m_constants(),m_nofArguments(nofArguments)
+{
+	m_nodes.reserve( nofArguments);
+	for (std::size_t ai = 0; ai < nofArguments; ++ai)
+	{
+		m_nodes.push_back( Node{ExpressionOp::Argument, {ai, 0}});
+	}
+}
+
+ExpressionGraph::NodeIndex ExpressionGraph::constant( const BigInt& value)
+{
+	m_constants.push_back( value);
+	m_nodes.push_back( Node{ExpressionOp::Constant, {m_constants.size()-1, 0}});
+	return m_nodes.size()-1;
+}
+
+ExpressionGraph::NodeIndex ExpressionGraph::operation( ExpressionOp op, NodeIndex arg1, NodeIndex arg2)
+{
+	if (!is_operation( op)) throw std::logic_error( "expected operation for expression node");
+	if (op == ExpressionOp::Neg) arg2 = 0;
+	if (arg1 >= m_nodes.size() || arg2 >= m_nodes.size()) throw std::logic_error( "operand of expression node out of range");
+	m_nodes.push_back( Node{op, {arg1, arg2}});
+	return m_nodes.size()-1;
+}
+
+std::string ExpressionGraph::tostring( NodeIndex root) const
+{
+	if (root >= m_nodes.size()) throw std::logic_error( "expression root out of range");
+	// ... built bottom up without recursion, long subexpressions are abbreviated
+	std::vector<bool> reachable( root+1, false);
+	reachable[ root] = true;
+	for (std::size_t ni = root+1; ni > 0; --ni)
+	{
+		if (!reachable[ ni-1]) continue;
+		for (int oi = 0; oi < nof_operands( m_nodes[ ni-1].op); ++oi) reachable[ m_nodes[ ni-1].arg[ oi]] = true;
+	}
+	std::vector<std::string> strings( root+1);
+	auto operand = [&strings]( NodeIndex ni) -> std::string
+	{
+		return strings[ ni].size() > MaxSubexpressionString ? std::string("...") : strings[ ni];
+	};
+	for (std::size_t ni = 0; ni <= root; ++ni)
+	{
+		if (!reachable[ ni]) continue;
+		const Node& node = m_nodes[ ni];
+		const char* opname = "";
+		switch (node.op)
+		{
+			case ExpressionOp::Argument: strings[ ni] = "$" + std::to_string( node.arg[ 0]+1); continue;
+			case ExpressionOp::Constant: strings[ ni] = m_constants[ node.arg[ 0]].tostring(); continue;
+			case ExpressionOp::Neg: strings[ ni] = "-" + operand( node.arg[ 0]); continue;
+			case ExpressionOp::Add: opname = " + "; break;
+			case ExpressionOp::Sub: opname = " - "; break;
+			case ExpressionOp::Mul: opname = " * "; break;
+			case ExpressionOp::Div: opname = " / "; break;
+			case ExpressionOp::Mod: opname = " % "; break;
+		}
+		strings[ ni] = "(" + operand( node.arg[ 0]) + opname + operand( node.arg[ 1]) + ")";
+	}
+	return strings[ root];
+}
+
+CompiledExpression::CompiledExpression( const ExpressionGraph& graph, ExpressionGraph::NodeIndex root)
+	:m_constants(graph.m_constants),m_program(),m_terms(),m_temporaries()
+	,m_sumOperands(),m_sumNegate(),m_result{OperandKind::Argument,0},m_nofArguments(graph.m_nofArguments)
+{
+	typedef ExpressionGraph::Node Node;
+	const std::vector<Node>& nodes = graph.m_nodes;
+	if (root >= nodes.size()) throw std::logic_error( "expression root out of range");
+
+	// ... count the uses of the nodes reachable from the root
+	std::vector<std::size_t> uses( root+1, 0);
+	std::vector<bool> reachable( root+1, false);
+	reachable[ root] = true;
+	for (std::size_t ni = root+1; ni > 0; --ni)
+	{
+		const Node& node = nodes[ ni-1];
+		if (!reachable[ ni-1]) continue;
+		for (int oi = 0; oi < nof_operands( node.op); ++oi)
+		{
+			reachable[ node.arg[ oi]] = true;
+			++uses[ node.arg[ oi]];
+		}
+	}
+	// ... subexpressions used only once are fused into their user, sums into sums and a product into the remainder taken of it
+	std::vector<bool> fused( root+1, false);
+	for (std::size_t ni = 0; ni <= root; ++ni)
+	{
+		const Node& node = nodes[ ni];
+		if (!reachable[ ni]) continue;
+		if (is_sum( node.op))
+		{
+			for (int oi = 0; oi < nof_operands( node.op); ++oi)
+			{
+				if (is_sum( nodes[ node.arg[ oi]].op) && uses[ node.arg[ oi]] == 1) fused[ node.arg[ oi]] = true;
+			}
+		}
+		else if (node.op == ExpressionOp::Mod && nodes[ node.arg[ 0]].op == ExpressionOp::Mul && uses[ node.arg[ 0]] == 1)
+		{
+			fused[ node.arg[ 0]] = true;
+		}
+	}
+	// ... emit the instructions in the order of the nodes, the operands are evaluated before their users
+	std::vector<Operand> operands( root+1, Operand{OperandKind::Argument,0});
+	std::vector<std::pair<ExpressionGraph::NodeIndex,bool> > sumstack;
+	for (std::size_t ni = 0; ni <= root; ++ni)
+	{
+		const Node& node = nodes[ ni];
+		if (!reachable[ ni] || fused[ ni]) continue;
+
+		Instruction instr;
+		instr.op = InstructionOp::Sum;
+		instr.result = m_temporaries.size();
+		instr.arg[ 0] = instr.arg[ 1] = instr.arg[ 2] = Operand{OperandKind::Argument,0};
+		instr.termsStart = m_terms.size();
+		instr.nofTerms = 0;
+		std::size_t nofTemporaries = 1;
+
+		switch (node.op)
+		{
+			case ExpressionOp::Argument:
+				operands[ ni] = Operand{OperandKind::Argument, node.arg[ 0]};
+				continue;
+			case ExpressionOp::Constant:
+				operands[ ni] = Operand{OperandKind::Constant, node.arg[ 0]};
+				continue;
+			case ExpressionOp::Add:
+			case ExpressionOp::Sub:
+			case ExpressionOp::Neg:
+				sumstack.push_back( {ni, false});
+				while (!sumstack.empty())
+				{
+					const Node& sumnode = nodes[ sumstack.back().first];
+					bool negative = sumstack.back().second;
+					sumstack.pop_back();
+					for (int oi = 0; oi < nof_operands( sumnode.op); ++oi)
+					{
+						bool termNegative = (oi == 1 || sumnode.op == ExpressionOp::Neg) && sumnode.op != ExpressionOp::Add ? !negative : negative;
+						if (fused[ sumnode.arg[ oi]])
+						{
+							sumstack.push_back( {sumnode.arg[ oi], termNegative});
+						}
+						else
+						{
+							m_terms.push_back( Term{operands[ sumnode.arg[ oi]], termNegative});
+						}
+					}
+				}
+				instr.nofTerms = m_terms.size() - instr.termsStart;
+				break;
+			case ExpressionOp::Mul:
+				instr.op = InstructionOp::Mul;
+				instr.arg[ 0] = operands[ node.arg[ 0]];
+				instr.arg[ 1] = operands[ node.arg[ 1]];
+				break;
+			case ExpressionOp::Div:
+				instr.op = InstructionOp::Div;
+				instr.arg[ 0] = operands[ node.arg[ 0]];
+				instr.arg[ 1] = operands[ node.arg[ 1]];
+				break;
+			case ExpressionOp::Mod:
+				if (fused[ node.arg[ 0]])
+				{
+					// ... the result, the two reduced factors and the product
+					const Node& product = nodes[ node.arg[ 0]];
+					instr.op = InstructionOp::MulMod;
+					instr.arg[ 0] = operands[ product.arg[ 0]];
+					instr.arg[ 1] = operands[ product.arg[ 1]];
+					instr.arg[ 2] = operands[ node.arg[ 1]];
+					nofTemporaries = 4;
+				}
+				else
+				{
+					instr.op = InstructionOp::Mod;
+					instr.arg[ 0] = operands[ node.arg[ 0]];
+					instr.arg[ 1] = operands[ node.arg[ 1]];
+				}
+				break;
+		}
+		m_temporaries.resize( m_temporaries.size() + nofTemporaries);
+		m_program.push_back( instr);
+		operands[ ni] = Operand{OperandKind::Temporary, instr.result};
+	}
+	m_result = operands[ root];
+}
+
+const BigInt& CompiledExpression::value( const Operand& opr, const BigInt* const* args) const noexcept
+{
+	switch (opr.kind)
+	{
+		case OperandKind::Argument: return *args[ opr.idx];
+		case OperandKind::Constant: return m_constants[ opr.idx];
+		case OperandKind::Temporary: break;
+	}
+	return m_temporaries[ opr.idx];
+}
+
+void CompiledExpression::evaluateSum( const Instruction& instr, const BigInt* const* args)
+{
+	BigInt& rt = m_temporaries[ instr.result];
+	const Term* terms = m_terms.data() + instr.termsStart;
+	if (instr.nofTerms == 1)
+	{
+		// ... shares the elements of the operand
+		rt = value( terms[ 0].operand, args);
+		if (terms[ 0].negative) rt.invert_sign();
+	}
+	else if (instr.nofTerms == 2)
+	{
+		// ... the kernels for small numbers are faster than the accumulator for two terms
+		const BigInt& t1 = value( terms[ 0].operand, args);
+		const BigInt& t2 = value( terms[ 1].operand, args);
+		if (terms[ 0].negative == terms[ 1].negative)
+		{
+			rt.assign_add( t1, t2);
+			if (terms[ 0].negative) rt.invert_sign();
+		}
+		else if (terms[ 1].negative)
+		{
+			rt.assign_sub( t1, t2);
+		}
+		else
+		{
+			rt.assign_sub( t2, t1);
+		}
+	}
+	else
+	{
+		m_sumOperands.clear();
+		m_sumNegate.clear();
+		for (std::size_t ti = 0; ti < instr.nofTerms; ++ti)
+		{
+			m_sumOperands.push_back( &value( terms[ ti].operand, args));
+			m_sumNegate.push_back( terms[ ti].negative);
+		}
+		BigInt sum = BigInt::sum( m_sumOperands, m_sumNegate);
+		rt.swap( sum);
+	}
+}
+
+void CompiledExpression::evaluateMulMod( const Instruction& instr, const BigInt* const* args)
+{
+	// ... the remainder of the product does not change if the factors are replaced by their remainders,
+	//	as the remainder is taken of the absolute values
+	const BigInt& modulus = value( instr.arg[ 2], args);
+	const BigInt* factors[ 2];
+	for (int fi = 0; fi < 2; ++fi)
+	{
+		factors[ fi] = &value( instr.arg[ fi], args);
+		if (factors[ fi]->nof_digits() >= modulus.nof_digits())
+		{
+			BigInt& reduced = m_temporaries[ instr.result + 1 + fi];
+			reduced.assign_mod( *factors[ fi], modulus);
+			factors[ fi] = &reduced;
+		}
+	}
+	BigInt& product = m_temporaries[ instr.result + 3];
+	product.assign_mul( *factors[ 0], *factors[ 1]);
+	m_temporaries[ instr.result].assign_mod( product, modulus);
+}
+
+BigInt CompiledExpression::evaluate( const BigInt* const* args)
+{
+	for (const Instruction& instr : m_program)
+	{
+		BigInt& rt = m_temporaries[ instr.result];
+		switch (instr.op)
+		{
+			case InstructionOp::Sum:
+				evaluateSum( instr, args);
+				break;
+			case InstructionOp::Mul:
+				rt.assign_mul( value( instr.arg[ 0], args), value( instr.arg[ 1], args));
+				break;
+			case InstructionOp::MulMod:
+				evaluateMulMod( instr, args);
+				break;
+			case InstructionOp::Div:
+			{
+				std::pair<BigInt,BigInt> res = value( instr.arg[ 0], args).div( value( instr.arg[ 1], args));
+				rt.swap( res.first);
+				break;
+			}
+			case InstructionOp::Mod:
+				rt.assign_mod( value( instr.arg[ 0], args), value( instr.arg[ 1], args));
+				break;
+		}
+	}
+	return value( m_result, args);
+}
+
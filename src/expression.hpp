@@ -0,0 +1,125 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file expression.hpp
+///\brief Expressions on BigInt numbers built as graph of operations and evaluated as a whole
+#ifndef _BCD_EXPRESSION_HPP_INCLUDED
+#define _BCD_EXPRESSION_HPP_INCLUDED
+#include "bcd.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace bcd {
+
+///\brief Operations of the nodes of an expression graph
+enum class ExpressionOp : unsigned char
+{
+	Argument,	///< argument of the evaluation
+	Constant,	///< constant number
+	Add,
+	Sub,
+	Mul,
+	Div,		///< quotient of the division
+	Mod,		///< remainder of the division, not negative as BigInt::mod
+	Neg
+};
+
+///\class ExpressionGraph
+///\brief Graph of the operations of expressions on a fixed number of arguments
+///\note Nodes are only added, never changed, so expressions sharing a graph share their common subexpressions
+class ExpressionGraph
+{
+public:
+	typedef std::size_t NodeIndex;
+
+	/// \brief Constructor
+	/// \param[in] nofArguments number of arguments, the nodes 0 to nofArguments-1 are the arguments
+	explicit ExpressionGraph( std::size_t nofArguments);
+
+	/// \brief Get the number of arguments
+	std::size_t nofArguments() const noexcept			{return m_nofArguments;}
+	/// \brief Add a constant node
+	NodeIndex constant( const BigInt& value);
+	/// \brief Add an operation node on existing nodes, the second operand is ignored for the negation
+	NodeIndex operation( ExpressionOp op, NodeIndex arg1, NodeIndex arg2);
+	/// \brief Get the expression with a root node in infix notation, with deep subexpressions abbreviated
+	std::string tostring( NodeIndex root) const;
+
+private:
+	friend class CompiledExpression;
+	struct Node
+	{
+		ExpressionOp op;
+		NodeIndex arg[ 2];	///< operand nodes of an operation, index of the argument or of the constant otherwise
+	};
+
+	std::vector<Node> m_nodes;		///< nodes in the order of creation, operands before the operations using them
+	std::vector<BigInt> m_constants;	///< values of the constant nodes
+	std::size_t m_nofArguments;		///< number of argument nodes
+};
+
+///\class CompiledExpression
+///\brief Program evaluating an expression of a graph in one go
+///\remark Chains of additions, subtractions and negations are evaluated as one sum with a single carry normalization,
+///	the factors of a product are reduced by the modulus of a remainder taken of the product before the multiplication,
+///	the temporaries keep their elements for the next evaluation
+///\note Not thread safe, evaluations reuse the temporaries
+class CompiledExpression
+{
+public:
+	/// \brief Constructor, compiles the expression with a root node of a graph
+	CompiledExpression( const ExpressionGraph& graph, ExpressionGraph::NodeIndex root);
+
+	/// \brief Get the number of arguments expected by evaluate
+	std::size_t nofArguments() const noexcept			{return m_nofArguments;}
+	/// \brief Evaluate the expression
+	/// \param[in] args as many arguments as the graph of the expression has
+	BigInt evaluate( const BigInt* const* args);
+
+private:
+	enum class OperandKind : unsigned char {Argument, Constant, Temporary};
+	struct Operand
+	{
+		OperandKind kind;
+		std::size_t idx;
+	};
+	enum class InstructionOp : unsigned char {Sum, Mul, MulMod, Div, Mod};
+	struct Instruction
+	{
+		InstructionOp op;
+		std::size_t result;		///< index of the temporary of the result, followed by the scratch temporaries of MulMod
+		Operand arg[ 3];		///< operands, factors and modulus for MulMod
+		std::size_t termsStart;		///< start of the terms of a Sum in m_terms
+		std::size_t nofTerms;		///< number of terms of a Sum
+	};
+	struct Term
+	{
+		Operand operand;
+		bool negative;
+	};
+
+	const BigInt& value( const Operand& opr, const BigInt* const* args) const noexcept;
+	void evaluateSum( const Instruction& instr, const BigInt* const* args);
+	void evaluateMulMod( const Instruction& instr, const BigInt* const* args);
+
+private:
+	std::vector<BigInt> m_constants;	///< constants of the graph, sharing their elements with the graph
+	std::vector<Instruction> m_program;	///< instructions in the order of evaluation
+	std::vector<Term> m_terms;		///< terms of the sums
+	std::vector<BigInt> m_temporaries;	///< results of the instructions, kept between evaluations
+	std::vector<const BigInt*> m_sumOperands;	///< buffer for sums with more than two terms
+	std::vector<bool> m_sumNegate;		///< buffer for sums with more than two terms
+	Operand m_result;			///< operand with the result of the expression
+	std::size_t m_nofArguments;		///< number of arguments expected
+};
+
+}//namespace
+#endif
+
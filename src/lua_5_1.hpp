@@ -27,8 +27,34 @@ static void luaL_setfuncs (lua_State *L, const luaL_Reg *l, int nup) {
 	lua_pop(L, nup);  /* remove upvalues */
 }
 
+static void *luaL_testudata (lua_State *L, int ud, const char *tname) {
+	void *p = lua_touserdata(L, ud);
+	if (p != NULL) {  /* value is a userdata? */
+		if (lua_getmetatable(L, ud)) {  /* does it have a metatable? */
+			luaL_getmetatable(L, tname);  /* get correct metatable */
+			if (!lua_rawequal(L, -1, -2))  /* not the same? */
+				p = NULL;  /* value is a userdata with wrong metatable */
+			lua_pop(L, 2);  /* remove both metatables */
+			return p;
+		}
+	}
+	return NULL;  /* value is not a userdata with a metatable */
+}
+
 #define luaL_newlibtable(L,l)	lua_createtable(L, 0, sizeof(l)/sizeof((l)[0]) - 1)
 #define luaL_newlib(L, l) 	(luaL_newlibtable(L,l), luaL_setfuncs(L,l,0))
+#define lua_rawlen(L,i)		lua_objlen(L,i)
+
+/*
+** File handles of the io library are userdata with a FILE* in Lua 5.1
+*/
+#include <stdio.h>
+#ifndef LUA_FILEHANDLE
+#define LUA_FILEHANDLE		"FILE*"
+#endif
+typedef struct luaL_Stream {
+	FILE *f;
+} luaL_Stream;
 
 #endif
 
@@ -10,10 +10,22 @@
 ///\file lualib_bcd.cpp
 ///\brief Implements the Lua ADT for BCD arithmetics
 #include "bcd.hpp"
+#include "trace.hpp"
+#include "expression.hpp"
+#include "numberfile.hpp"
 #include "lua_5_1.hpp"
 #include "export.hpp"
 #include <limits>
 #include <stdexcept>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#ifdef BCD_USDT
+#include <sys/sdt.h>
+#endif
 extern "C" {
 #include <lua.h>
 #include <lauxlib.h>
@@ -66,6 +78,8 @@ static void lippincottFunction( lua_State* ls)
 	}
 }
 
+// Name of the registry table with weak values mapping strings to bcd.int values parsed from them
+static const char* g_operandCacheName = "bcd.operandcache";
 
 struct bcd_int_userdata_t
 {
@@ -74,6 +88,12 @@ public:
 	{
 		m_value.init();
 	}
+	void init( std::size_t capacity) noexcept
+	{
+		// ... the elements are stored inline after the userdata structure
+		m_value.init();
+		m_value.attach( (bcd::BigInt::Element*)(this+1), capacity);
+	}
 	void create( const char* val, std::size_t valsize)
 	{
 		m_value.init( val, valsize);
@@ -152,16 +172,258 @@ static int bcd_bits_create( lua_State* ls)
 	return 1;
 }
 
+static int bcd_set_threads( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.set_threads";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+		if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		if (lua_type( ls, 1) != LUA_TNUMBER || lua_tointeger( ls, 1) < 0)
+		{
+			throw std::runtime_error( std::string("expected non negative integer as number of threads for ") + functionName);
+		}
+		if (nn > 1)
+		{
+			if (lua_type( ls, 2) != LUA_TNUMBER || lua_tointeger( ls, 2) < 0)
+			{
+				throw std::runtime_error( std::string("expected non negative integer as number of digits for ") + functionName);
+			}
+			bcd::BigInt::setParallelThreshold( lua_tointeger( ls, 2));
+		}
+		bcd::BigInt::setNofThreads( lua_tointeger( ls, 1));
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 0;
+}
+
+static int bcd_memory( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.memory";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn > 0) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		lua_pushinteger( ls, bcd::BigInt::memoryInUse());
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 1;
+}
+
+static int bcd_stats( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.stats";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn > 0) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		if (!lua_checkstack( ls, 6)) throw std::bad_alloc();
+		std::vector<bcd::BigInt::OperationStatistics> statistics = bcd::BigInt::statistics();
+		lua_newtable( ls);
+		for (auto const& op : statistics)
+		{
+			if (!op.count) continue;
+			lua_newtable( ls);
+			lua_pushinteger( ls, op.count);
+			lua_setfield( ls, -2, "count");
+			lua_pushinteger( ls, op.nanoseconds);
+			lua_setfield( ls, -2, "ns");
+			lua_pushinteger( ls, op.allocations);
+			lua_setfield( ls, -2, "allocs");
+			lua_pushinteger( ls, op.allocatedBytes);
+			lua_setfield( ls, -2, "bytes");
+			// ... histogram as map from the lower bound of the size class in elements to the number of calls
+			lua_newtable( ls);
+			for (std::size_t si = 0; si < bcd::BigInt::NofSizeClasses; ++si)
+			{
+				if (!op.sizes[ si]) continue;
+				lua_pushinteger( ls, op.sizes[ si]);
+				lua_rawseti( ls, -2, si ? ((lua_Integer)1 << (si-1)) : 0);
+			}
+			lua_setfield( ls, -2, "sizes");
+			lua_setfield( ls, -2, op.name);
+		}
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 1;
+}
+
+static int bcd_stats_reset( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.stats_reset";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn > 0) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		bcd::BigInt::resetStatistics();
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 0;
+}
+
+// Trace of the operations written between bcd.trace_start and bcd.trace_stop, shared by all Lua states
+static std::mutex g_traceMutex;
+static std::unique_ptr<bcd::TraceWriter> g_traceWriter;
+static std::atomic<bool> g_traceActive( false);
+
+template <typename... Operands>
+static void traceOperation( bcd::TraceOp op, const Operands&... operands)
+{
+	if (g_traceActive.load( std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock( g_traceMutex);
+		if (g_traceWriter) g_traceWriter->write( op, operands...);
+	}
+}
+
+static int bcd_trace_start( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.trace_start";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+		if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		if (lua_type( ls, 1) != LUA_TSTRING)
+		{
+			throw std::runtime_error( std::string("expected file path as argument for ") + functionName);
+		}
+		bool withValues = true;
+		if (nn > 1)
+		{
+			const char* mode = lua_type( ls, 2) == LUA_TSTRING ? lua_tostring( ls, 2) : "";
+			if (0==std::strcmp( mode, "sizes"))
+			{
+				withValues = false;
+			}
+			else if (0!=std::strcmp( mode, "values"))
+			{
+				throw std::runtime_error( std::string("expected 'values' or 'sizes' as mode argument for ") + functionName);
+			}
+		}
+		std::lock_guard<std::mutex> lock( g_traceMutex);
+		if (g_traceWriter) throw std::runtime_error( std::string("trace already started calling ") + functionName);
+		g_traceWriter.reset( new bcd::TraceWriter( lua_tostring( ls, 1), withValues));
+		g_traceActive = true;
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 0;
+}
+
+static int bcd_trace_stop( lua_State* ls)
+{
+	[[maybe_unused]] static const char* functionName = "bcd.trace_stop";
+	try
+	{
+		int nn = lua_gettop( ls);
+		if (nn > 0) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+		std::lock_guard<std::mutex> lock( g_traceMutex);
+		g_traceActive = false;
+		std::unique_ptr<bcd::TraceWriter> writer( std::move( g_traceWriter));
+		if (writer) writer->close();
+	}
+	catch (...) { lippincottFunction( ls); }
+	return 0;
+}
+
+static std::atomic<std::size_t> g_memoryCharged( 0);
+
+// ... make the collector aware of the memory allocated for numbers outside of userdata, charged in steps of 1K
+static void chargeMemory( lua_State* ls) noexcept
+{
+	std::size_t allocated = bcd::BigInt::memoryAllocated();
+	std::size_t charged = g_memoryCharged;
+	std::size_t kb = (allocated - charged) / 1024;
+	if (kb && g_memoryCharged.compare_exchange_strong( charged, charged + kb * 1024))
+	{
+		lua_gc( ls, LUA_GCSTEP, (int)std::min( kb, (std::size_t)std::numeric_limits<int>::max()));
+	}
+}
+
+#ifdef BCD_USDT
+// ... fires the static tracepoints bcd:method_entry( name, elements of the operands) on construction and bcd:method_return( name, elements of the result) on destruction
+class MethodProbeScope
+{
+public:
+	MethodProbeScope( const char* functionName, std::size_t size1, std::size_t size2) noexcept
+		:m_functionName(functionName),m_result(nullptr)
+	{
+		DTRACE_PROBE3( bcd, method_entry, functionName, size1, size2);
+	}
+	~MethodProbeScope()
+	{
+		std::size_t size = m_result ? m_result->nof_elements() : 0;
+		DTRACE_PROBE2( bcd, method_return, m_functionName, size);
+	}
+	void setResult( const bcd::BigInt* result) noexcept
+	{
+		m_result = result;
+	}
+
+private:
+	const char* m_functionName;
+	const bcd::BigInt* m_result;
+};
+
+// Get the number of elements of the bcd.int at 'idx' for the probes, 0 if the argument is of another type
+static std::size_t nofOperandElements( lua_State* ls, int idx) noexcept
+{
+	std::size_t rt = 0;
+	if (lua_type( ls, idx) == LUA_TUSERDATA && lua_getmetatable( ls, idx))
+	{
+		luaL_getmetatable( ls, bcd_int_userdata_t::metatableName());
+		if (lua_rawequal( ls, -1, -2))
+		{
+			rt = ((bcd_int_userdata_t*)lua_touserdata( ls, idx))->m_value.nof_elements();
+		}
+		lua_pop( ls, 2);
+	}
+	return rt;
+}
+#define BCD_METHOD_PROBE_SCOPE( functionName, size1, size2)	MethodProbeScope methodProbeScope( functionName, size1, size2)
+#define BCD_METHOD_PROBE_RESULT( result)			methodProbeScope.setResult( result)
+#else
+#define BCD_METHOD_PROBE_SCOPE( functionName, size1, size2)
+#define BCD_METHOD_PROBE_RESULT( result)
+#endif
+
+// Test if the argument at 'idx' is a bcd.expr, defined with the methods of bcd.expr
+static bool isExpression( lua_State* ls, int idx) noexcept;
+// Build the expression of an operation of a bcd.int with a bcd.expr as second operand
+static int expressionOperation( lua_State* ls, const char* functionName, bcd::TraceOp traceOp);
+
+// Test if a Lua file handle is closed, closed files keep their handle in Lua 5.2 and later
+static bool isClosedFile( const luaL_Stream* stream) noexcept
+{
+#if LUA_VERSION_NUM >= 502
+	return stream->closef == nullptr;
+#else
+	return stream->f == nullptr;
+#endif
+}
+
 template <class UD>
 struct LuaMethods
 {
 	static UD* newuserdata( lua_State* ls) noexcept
 	{
+		chargeMemory( ls);
 		UD* rt = (UD*)lua_newuserdata( ls, sizeof(UD));
 		luaL_getmetatable( ls, UD::metatableName());
 		lua_setmetatable( ls, -2);
 		return rt;
 	}
+	static UD* newuserdata( lua_State* ls, std::size_t capacity) noexcept
+	{
+		// ... single allocation for the userdata and the elements of the number
+		chargeMemory( ls);
+		UD* rt = (UD*)lua_newuserdata( ls, sizeof(UD) + capacity * sizeof(bcd::BigInt::Element));
+		rt->init( capacity);
+		luaL_getmetatable( ls, UD::metatableName());
+		lua_setmetatable( ls, -2);
+		return rt;
+	}
 	static int create( lua_State* ls)
 	{
 		try
@@ -170,6 +432,7 @@ struct LuaMethods
 			if (nn < 1) throw std::runtime_error( "too few arguments calling BCD constructor");
 			if (nn > 1) throw std::runtime_error( "too many arguments calling BCD constructor");
 			UD* ud = newuserdata( ls);
+			ud->init();
 			switch (lua_type( ls, 1))
 			{
 				case LUA_TSTRING:
@@ -177,11 +440,23 @@ struct LuaMethods
 					std::size_t len;
 					const char* str = lua_tolstring( ls, 1, &len);
 					ud->m_value.init( str, len);
+					traceOperation( bcd::TraceOp::Parse, ud->m_value);
 					break;
 				}
 				case LUA_TNUMBER:
 				{
 					long operand = lua_tointeger( ls, 1);
+					if (!operand)
+					{
+						// ... lua_tointeger returns 0 for numbers with a fraction part or out of range in Lua 5.3 and later
+						lua_Number num = lua_tonumber( ls, 1);
+						if (num <= -9.2e18 || num >= 9.2e18)
+						{
+							ud->create( num);
+							break;
+						}
+						operand = (long)num;
+					}
 					ud->m_value.init( operand);
 					break;
 				}
@@ -214,217 +489,528 @@ struct LuaMethods
 		return 0;
 	}
 
-	static int tostring( lua_State* ls)
+	static int release( lua_State* ls)
 	{
+		[[maybe_unused]] static const char* functionName = "bcd:free";
 		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
 		try
 		{
-			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			// ... called as __close with the error object as 2nd argument
 			int nn = lua_gettop( ls);
-			if (nn > 1) throw std::runtime_error("too many arguments calling __tostring");
-			std::string val = ud->m_value.tostring();
-			lua_pushlstring( ls, val.c_str(), val.size());
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			ud->m_value.release();
 		}
 		catch (...) { lippincottFunction( ls); }
-		return 1;
+		return 0;
 	}
 
-	static int tonumber( lua_State* ls)
+	static int sum( lua_State* ls)
 	{
-		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		[[maybe_unused]] static const char* functionName = "bcd.sum";
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
 			int nn = lua_gettop( ls);
-			if (nn > 1) throw std::runtime_error("too many arguments calling tonumber");
-			lua_pushnumber( ls, ud->m_value.todouble());
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			std::vector<const ValueType*> list;
+			std::deque<ValueType> buf;
+			getListArgument( ls, 1, functionName, list, buf);
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = bcd::BigInt::sum( list);
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
 	}
 
-	typedef typename UD::ValueType ValueType;
-
-	static int cmpop( lua_State* ls, const char* functionName, bool (ValueType::*Method)( const ValueType&) const noexcept)
+	static int dot( lua_State* ls)
 	{
-		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		[[maybe_unused]] static const char* functionName = "bcd.dot";
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
 			int nn = lua_gettop( ls);
 			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
 			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
-			switch (lua_type( ls, 2))
-			{
-				case LUA_TSTRING:
-				{
-					std::size_t len;
-					const char* str = lua_tolstring( ls, 2, &len);
-					bcd::BigInt operand( str, len);
-					lua_pushboolean( ls, (ud->m_value.*Method)( operand));
-					break;
-				}
-				case LUA_TNUMBER:
-				{
-					long intarg = lua_tointeger( ls, 2);
-					bcd::BigInt operand( intarg);
-					lua_pushboolean( ls, (ud->m_value.*Method)( operand));
-					break;
-				}
-				case LUA_TUSERDATA:
-				{
-					UD* operand_ud = (UD*)luaL_checkudata( ls, 2, UD::metatableName());
-					lua_pushboolean( ls, (ud->m_value.*Method)( operand_ud->m_value));
-					break;
-				}
-				default:
-					throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
-			}
+			std::vector<const ValueType*> list1, list2;
+			std::deque<ValueType> buf;
+			getListArgument( ls, 1, functionName, list1, buf);
+			getListArgument( ls, 2, functionName, list2, buf);
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = bcd::BigInt::dot( list1, list2);
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
 	}
 
-	static int binop( lua_State* ls, const char* functionName, ValueType (ValueType::*Method)( const ValueType&) const)
+	static int tostring( lua_State* ls)
 	{
 		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( "bcd:__tostring", ud->m_value.nof_elements(), 0);
 			int nn = lua_gettop( ls);
-			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
-			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
-			switch (lua_type( ls, 2))
-			{
-				case LUA_TSTRING:
-				{
-					std::size_t len;
-					const char* str = lua_tolstring( ls, 2, &len);
-					bcd::BigInt operand( str, len);
-					UD* res_ud = newuserdata( ls);
-					res_ud->init();
-					res_ud->m_value = (ud->m_value.*Method)( operand);
-					break;
-				}
-				case LUA_TNUMBER:
-				{
-					long intarg = lua_tointeger( ls, 2);
-					bcd::BigInt operand( intarg);
-					UD* res_ud = newuserdata( ls);
-					res_ud->init();
-					res_ud->m_value = (ud->m_value.*Method)( operand);
-					break;
-				}
-				case LUA_TUSERDATA:
-				{
-					UD* operand_ud = (UD*)luaL_checkudata( ls, 2, UD::metatableName());
-					UD* res_ud = newuserdata( ls);
-					res_ud->init();
-					res_ud->m_value = (ud->m_value.*Method)( operand_ud->m_value);
-					break;
-				}
-				default:
-					throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
-			}
+			if (nn > 1) throw std::runtime_error("too many arguments calling __tostring");
+			std::string val = ud->m_value.tostring();
+			traceOperation( bcd::TraceOp::ToString, ud->m_value);
+			lua_pushlstring( ls, val.c_str(), val.size());
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
 	}
 
-	static int unop( lua_State* ls, const char* functionName, ValueType (ValueType::*Method)() const)
+	static int tonumber( lua_State* ls)
 	{
 		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
 		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn > 1) throw std::runtime_error("too many arguments calling tonumber");
+			lua_pushnumber( ls, ud->m_value.todouble());
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int load( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.load";
+		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
 			int nn = lua_gettop( ls);
 			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
-			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
-			// ... Lua adds a fake 2nd operand without meaning (See http://lua-users.org/lists/lua-l/2016-10/msg00347.html)
-			// [Lua 5.3 User's Manual]: For the unary operators (negation, length, and bitwise not), the metamethod is computed and called with a dummy second operand, equal to the first one. This extra operand is only to simplify Lua's internals (by making these operators behave like a binary operation) and may be removed in future versions. (For most uses this extra operand is irrelevant.)
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 1) != LUA_TSTRING) throw std::runtime_error( std::string("expected file path as argument for ") + functionName);
+			bcd::BigInt value = bcd::loadNumber( lua_tostring( ls, 1));
 			UD* res_ud = newuserdata( ls);
 			res_ud->init();
-			res_ud->m_value = (ud->m_value.*Method)();
+			res_ud->m_value.swap( value);
+			traceOperation( bcd::TraceOp::Parse, res_ud->m_value);
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
 	}
 
-	static int add( lua_State* ls)
-	{
-		return binop( ls, "bcd:__add", &bcd::BigInt::add);
-	}
-	static int sub( lua_State* ls)
+	static int save( lua_State* ls)
 	{
-		return binop( ls, "bcd:__sub", &bcd::BigInt::sub);
-	}
-	static int mod( lua_State* ls)
-	{
-		return binop( ls, "bcd:__mod", &bcd::BigInt::mod);
+		[[maybe_unused]] static const char* functionName = "bcd:save";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 2) != LUA_TSTRING) throw std::runtime_error( std::string("expected file path as argument for ") + functionName);
+			bcd::saveNumber( lua_tostring( ls, 2), ud->m_value);
+			traceOperation( bcd::TraceOp::Save, ud->m_value);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 0;
 	}
-	static int mul( lua_State* ls)
+
+	static int write( lua_State* ls)
 	{
-		return binop( ls, "bcd:__mul", &bcd::BigInt::mul);
+		[[maybe_unused]] static const char* functionName = "bcd:write";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		luaL_Stream* stream = (luaL_Stream*)luaL_checkudata( ls, 2, LUA_FILEHANDLE);
+		try
+		{
+			int nn = lua_gettop( ls);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (isClosedFile( stream)) throw std::runtime_error( std::string("attempt to use a closed file in ") + functionName);
+			bcd::writeNumber( (std::FILE*)stream->f, ud->m_value);
+			traceOperation( bcd::TraceOp::Write, ud->m_value);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 0;
 	}
-	static int pow( lua_State* ls)
+
+	static int pack( lua_State* ls)
 	{
-		[[maybe_unused]] static const char* functionName = "bcd:__pow";
+		[[maybe_unused]] static const char* functionName = "bcd:pack";
 		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
 			int nn = lua_gettop( ls);
-			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
-			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
-			if (lua_isnumber( ls, 2))
-			{
-				long operand = lua_tointeger( ls, 2);
-				if (operand < 0) throw std::runtime_error( std::string("expected non negative integer as argument for ") + functionName);
-				UD* res_ud = newuserdata( ls); res_ud->init();
-				res_ud->m_value = ud->m_value.pow( operand);
-			}
-			else
-			{
-				throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
-			}
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			std::string packed = ud->m_value.serialize();
+			lua_pushlstring( ls, packed.c_str(), packed.size());
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
 	}
 
-	static int div( lua_State* ls)
+	static int unpack( lua_State* ls)
 	{
-		[[maybe_unused]] static const char* functionName = "bcd:__div";
-		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		[[maybe_unused]] static const char* functionName = "bcd.unpack";
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
 			int nn = lua_gettop( ls);
-			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
-			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
-			switch (lua_type( ls, 2))
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 1) != LUA_TSTRING) throw std::runtime_error( std::string("expected packed number as argument for ") + functionName);
+			std::size_t len;
+			const char* packed = lua_tolstring( ls, 1, &len);
+			// ... references the elements in the string if possible, copied once into the storage of the result
+			bcd::BigInt value = bcd::BigInt::deserialize( packed, len);
+			UD* res_ud = newuserdata( ls, value.nof_elements());
+			res_ud->m_value.init( value);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	typedef typename UD::ValueType ValueType;
+
+	static unsigned long getUnsignedArgument( lua_State* ls, int idx, const char* functionName)
+	{
+		if (lua_type( ls, idx) != LUA_TNUMBER)
+		{
+			throw std::runtime_error( std::string("expected non negative integer as argument for ") + functionName);
+		}
+		// ... lua_tointeger truncates (Lua 5.1) or returns 0 (Lua 5.3 and later) for numbers without integer representation
+		lua_Integer rt = lua_tointeger( ls, idx);
+		if (rt < 0 || (lua_Number)rt != lua_tonumber( ls, idx))
+		{
+			throw std::runtime_error( std::string("expected non negative integer as argument for ") + functionName);
+		}
+		return rt;
+	}
+
+	// Get the list of numbers in the Lua array at 'idx', values converted from STRING or NUMBER are stored in 'buf'
+	static void getListArgument( lua_State* ls, int idx, const char* functionName, std::vector<const ValueType*>& list, std::deque<ValueType>& buf)
+	{
+		if (lua_type( ls, idx) != LUA_TTABLE)
+		{
+			throw std::runtime_error( std::string("expected array of numbers as argument for ") + functionName);
+		}
+		std::size_t ii = 0, nn = lua_rawlen( ls, idx);
+		list.reserve( nn);
+		for (; ii < nn; ++ii)
+		{
+			lua_rawgeti( ls, idx, ii+1);
+			switch (lua_type( ls, -1))
 			{
 				case LUA_TSTRING:
 				{
 					std::size_t len;
-					const char* str = lua_tolstring( ls, 2, &len);
-					bcd::BigInt operand( str, len);
+					const char* str = lua_tolstring( ls, -1, &len);
+					buf.emplace_back( str, len);
+					list.push_back( &buf.back());
+					break;
+				}
+				case LUA_TNUMBER:
+				{
+					long intarg = lua_tointeger( ls, -1);
+					buf.emplace_back( intarg);
+					list.push_back( &buf.back());
+					break;
+				}
+				case LUA_TUSERDATA:
+				{
+					// ... the value stays referenced by the table after popping it from the stack
+					UD* operand_ud = (UD*)luaL_checkudata( ls, -1, UD::metatableName());
+					list.push_back( &operand_ud->m_value);
+					break;
+				}
+				default:
+					throw std::runtime_error("expected STRING,NUMBER or USERDATA as array element");
+			}
+			lua_pop( ls, 1);
+		}
+	}
+
+	// Get the number parsed from the string at 'idx' from the cache of parsed operands, parse and insert it if not found
+	// ... the string at 'idx' is replaced by the cached number to keep it referenced during the operation
+	// ... the cache is keyed by string value, the lookup is O(1) for short strings (interned by Lua),
+	//	long strings (more than 40 bytes since Lua 5.2) are hashed and compared by content
+	static const ValueType& getCachedOperand( lua_State* ls, int idx)
+	{
+		if (!lua_checkstack( ls, 4)) throw std::bad_alloc();
+		lua_getfield( ls, LUA_REGISTRYINDEX, g_operandCacheName);
+		lua_pushvalue( ls, idx);
+		lua_rawget( ls, -2);
+		if (lua_type( ls, -1) != LUA_TUSERDATA)
+		{
+			lua_pop( ls, 1);
+			std::size_t len;
+			const char* str = lua_tolstring( ls, idx, &len);
+			UD* operand_ud = newuserdata( ls);
+			operand_ud->init();
+			operand_ud->m_value.init( str, len);
+			traceOperation( bcd::TraceOp::Parse, operand_ud->m_value);
+			lua_pushvalue( ls, idx);
+			lua_pushvalue( ls, -2);
+			lua_rawset( ls, -4);
+		}
+		UD* rt = (UD*)lua_touserdata( ls, -1);
+		lua_replace( ls, idx);
+		lua_pop( ls, 1);
+		return rt->m_value;
+	}
+
+	static int factorial( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.factorial";
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			unsigned long operand = getUnsignedArgument( ls, 1, functionName);
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = bcd::BigInt::factorial( operand);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int binomial( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.binomial";
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			unsigned long operand1 = getUnsignedArgument( ls, 1, functionName);
+			unsigned long operand2 = getUnsignedArgument( ls, 2, functionName);
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = bcd::BigInt::binomial( operand1, operand2);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int product( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.product";
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			std::vector<const ValueType*> list;
+			std::deque<ValueType> buf;
+			getListArgument( ls, 1, functionName, list, buf);
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = bcd::BigInt::product( list);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int cmpop( lua_State* ls, const char* functionName,
+				bool (ValueType::*Method)( const ValueType&) const noexcept,
+				bool (ValueType::*LongMethod)( long) const noexcept)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), nofOperandElements( ls, 2));
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			switch (lua_type( ls, 2))
+			{
+				case LUA_TSTRING:
+				{
+					const bcd::BigInt& operand = getCachedOperand( ls, 2);
+					lua_pushboolean( ls, (ud->m_value.*Method)( operand));
+					traceOperation( bcd::TraceOp::Compare, ud->m_value, operand);
+					break;
+				}
+				case LUA_TNUMBER:
+				{
+					long intarg = lua_tointeger( ls, 2);
+					lua_pushboolean( ls, (ud->m_value.*LongMethod)( intarg));
+					traceOperation( bcd::TraceOp::Compare, ud->m_value, intarg);
+					break;
+				}
+				case LUA_TUSERDATA:
+				{
+					UD* operand_ud = (UD*)luaL_checkudata( ls, 2, UD::metatableName());
+					lua_pushboolean( ls, (ud->m_value.*Method)( operand_ud->m_value));
+					traceOperation( bcd::TraceOp::Compare, ud->m_value, operand_ud->m_value);
+					break;
+				}
+				default:
+					throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int binop( lua_State* ls, const char* functionName, bcd::TraceOp traceOp,
+				void (ValueType::*Method)( const ValueType&, const ValueType&),
+				void (ValueType::*LongMethod)( const ValueType&, long),
+				std::size_t (ValueType::*Capacity)( const ValueType&) const noexcept,
+				std::size_t (ValueType::*LongCapacity)( long) const noexcept)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		if (isExpression( ls, 2)) return expressionOperation( ls, functionName, traceOp);
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), nofOperandElements( ls, 2));
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			switch (lua_type( ls, 2))
+			{
+				case LUA_TSTRING:
+				{
+					const bcd::BigInt& operand = getCachedOperand( ls, 2);
+					UD* res_ud = newuserdata( ls, (ud->m_value.*Capacity)( operand));
+					(res_ud->m_value.*Method)( ud->m_value, operand);
+					traceOperation( traceOp, ud->m_value, operand);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
+					break;
+				}
+				case LUA_TNUMBER:
+				{
+					long intarg = lua_tointeger( ls, 2);
+					UD* res_ud = newuserdata( ls, (ud->m_value.*LongCapacity)( intarg));
+					(res_ud->m_value.*LongMethod)( ud->m_value, intarg);
+					traceOperation( traceOp, ud->m_value, intarg);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
+					break;
+				}
+				case LUA_TUSERDATA:
+				{
+					UD* operand_ud = (UD*)luaL_checkudata( ls, 2, UD::metatableName());
+					UD* res_ud = newuserdata( ls, (ud->m_value.*Capacity)( operand_ud->m_value));
+					(res_ud->m_value.*Method)( ud->m_value, operand_ud->m_value);
+					traceOperation( traceOp, ud->m_value, operand_ud->m_value);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
+					break;
+				}
+				default:
+					throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int unop( lua_State* ls, const char* functionName, bcd::TraceOp traceOp, ValueType (ValueType::*Method)() const)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), 0);
+			int nn = lua_gettop( ls);
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			// ... Lua adds a fake 2nd operand without meaning (See http://lua-users.org/lists/lua-l/2016-10/msg00347.html)
+			// [Lua 5.3 User's Manual]: For the unary operators (negation, length, and bitwise not), the metamethod is computed and called with a dummy second operand, equal to the first one. This extra operand is only to simplify Lua's internals (by making these operators behave like a binary operation) and may be removed in future versions. (For most uses this extra operand is irrelevant.)
+			UD* res_ud = newuserdata( ls);
+			res_ud->init();
+			res_ud->m_value = (ud->m_value.*Method)();
+			traceOperation( traceOp, ud->m_value);
+			BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int add( lua_State* ls)
+	{
+		return binop( ls, "bcd:__add", bcd::TraceOp::Add, &bcd::BigInt::assign_add, &bcd::BigInt::assign_add, &bcd::BigInt::add_capacity, &bcd::BigInt::add_capacity);
+	}
+	static int sub( lua_State* ls)
+	{
+		return binop( ls, "bcd:__sub", bcd::TraceOp::Sub, &bcd::BigInt::assign_sub, &bcd::BigInt::assign_sub, &bcd::BigInt::add_capacity, &bcd::BigInt::add_capacity);
+	}
+	static int mod( lua_State* ls)
+	{
+		return binop( ls, "bcd:__mod", bcd::TraceOp::Mod, &bcd::BigInt::assign_mod, &bcd::BigInt::assign_mod, &bcd::BigInt::mod_capacity, &bcd::BigInt::mod_capacity);
+	}
+	static int mul( lua_State* ls)
+	{
+		return binop( ls, "bcd:__mul", bcd::TraceOp::Mul, &bcd::BigInt::assign_mul, &bcd::BigInt::assign_mul, &bcd::BigInt::mul_capacity, &bcd::BigInt::mul_capacity);
+	}
+	static int pow( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd:__pow";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), 0);
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_isnumber( ls, 2))
+			{
+				long operand = lua_tointeger( ls, 2);
+				if (operand < 0) throw std::runtime_error( std::string("expected non negative integer as argument for ") + functionName);
+				UD* res_ud = newuserdata( ls); res_ud->init();
+				res_ud->m_value = ud->m_value.pow( operand);
+				traceOperation( bcd::TraceOp::Pow, ud->m_value, operand);
+				BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
+			}
+			else
+			{
+				throw std::runtime_error("expected STRING,NUMBER or USERDATA as argument");
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int div( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd:__div";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		if (isExpression( ls, 2)) return expressionOperation( ls, functionName, bcd::TraceOp::Div);
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), nofOperandElements( ls, 2));
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			switch (lua_type( ls, 2))
+			{
+				case LUA_TSTRING:
+				{
+					const bcd::BigInt& operand = getCachedOperand( ls, 2);
 					UD* res1_ud = newuserdata( ls); res1_ud->init();
 					UD* res2_ud = newuserdata( ls); res2_ud->init();
 					std::pair<bcd::BigInt,bcd::BigInt> rr = (ud->m_value.div)( operand);
+					traceOperation( bcd::TraceOp::Div, ud->m_value, operand);
 					res1_ud->m_value.swap( rr.first);
 					res2_ud->m_value.swap( rr.second);
+					BCD_METHOD_PROBE_RESULT( &res1_ud->m_value);
 					break;
 				}
 				case LUA_TNUMBER:
 				{
 					long intarg = lua_tointeger( ls, 2);
-					bcd::BigInt operand( intarg);
 					UD* res1_ud = newuserdata( ls); res1_ud->init();
 					UD* res2_ud = newuserdata( ls); res2_ud->init();
-					std::pair<bcd::BigInt,bcd::BigInt> rr = (ud->m_value.div)( operand);
+					std::pair<bcd::BigInt,bcd::BigInt> rr = (ud->m_value.div)( intarg);
+					traceOperation( bcd::TraceOp::Div, ud->m_value, intarg);
 					res1_ud->m_value.swap( rr.first);
 					res2_ud->m_value.swap( rr.second);
+					BCD_METHOD_PROBE_RESULT( &res1_ud->m_value);
 					break;
 				}
 				case LUA_TUSERDATA:
@@ -433,8 +1019,10 @@ struct LuaMethods
 					UD* res1_ud = newuserdata( ls); res1_ud->init();
 					UD* res2_ud = newuserdata( ls); res2_ud->init();
 					std::pair<bcd::BigInt,bcd::BigInt> rr = (ud->m_value.div)( operand_ud->m_value);
+					traceOperation( bcd::TraceOp::Div, ud->m_value, operand_ud->m_value);
 					res1_ud->m_value.swap( rr.first);
 					res2_ud->m_value.swap( rr.second);
+					BCD_METHOD_PROBE_RESULT( &res1_ud->m_value);
 					break;
 				}
 				default:
@@ -445,21 +1033,71 @@ struct LuaMethods
 		return 2;
 	}
 
+	static int isqrt( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd:isqrt";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			UD* res1_ud = newuserdata( ls); res1_ud->init();
+			UD* res2_ud = newuserdata( ls); res2_ud->init();
+			std::pair<bcd::BigInt,bcd::BigInt> rr = ud->m_value.isqrt();
+			traceOperation( bcd::TraceOp::Root, ud->m_value, 2L);
+			res1_ud->m_value.swap( rr.first);
+			res2_ud->m_value.swap( rr.second);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 2;
+	}
+
+	static int iroot( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd:iroot";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 2) != LUA_TNUMBER)
+			{
+				throw std::runtime_error( std::string("expected positive integer as argument for ") + functionName);
+			}
+			long operand = lua_tointeger( ls, 2);
+			if (operand <= 0 || operand > std::numeric_limits<unsigned int>::max())
+			{
+				throw std::runtime_error( std::string("expected positive integer as argument for ") + functionName);
+			}
+			UD* res1_ud = newuserdata( ls); res1_ud->init();
+			UD* res2_ud = newuserdata( ls); res2_ud->init();
+			std::pair<bcd::BigInt,bcd::BigInt> rr = ud->m_value.iroot( (unsigned int)operand);
+			traceOperation( bcd::TraceOp::Root, ud->m_value, operand);
+			res1_ud->m_value.swap( rr.first);
+			res2_ud->m_value.swap( rr.second);
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 2;
+	}
+
 	static int unm( lua_State* ls)
 	{
-		return unop( ls, "bcd:__unm", &bcd::BigInt::neg);
+		return unop( ls, "bcd:__unm", bcd::TraceOp::Neg, &bcd::BigInt::neg);
 	}
 	static int lt( lua_State* ls)
 	{
-		return cmpop( ls, "bcd:__lt", &bcd::BigInt::cmplt);
+		return cmpop( ls, "bcd:__lt", &bcd::BigInt::cmplt, &bcd::BigInt::cmplt);
 	}
 	static int le( lua_State* ls)
 	{
-		return cmpop( ls, "bcd:__le", &bcd::BigInt::cmple);
+		return cmpop( ls, "bcd:__le", &bcd::BigInt::cmple, &bcd::BigInt::cmple);
 	}
 	static int eq( lua_State* ls)
 	{
-		return cmpop( ls, "bcd:__eq", &bcd::BigInt::cmpeq);
+		return cmpop( ls, "bcd:__eq", &bcd::BigInt::cmpeq, &bcd::BigInt::cmpeq);
 	}
 };
 
@@ -469,6 +1107,7 @@ struct BitwiseBigIntLuaMethods
 
 	static UD* newuserdata( lua_State* ls) noexcept
 	{
+		chargeMemory( ls);
 		UD* rt = (UD*)lua_newuserdata( ls, sizeof(UD));
 		luaL_getmetatable( ls, UD::metatableName());
 		lua_setmetatable( ls, -2);
@@ -481,6 +1120,7 @@ struct BitwiseBigIntLuaMethods
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), nofOperandElements( ls, 2));
 			int nn = lua_gettop( ls);
 			if (nn < 3) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
 			if (nn > 3) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
@@ -490,12 +1130,11 @@ struct BitwiseBigIntLuaMethods
 			{
 				case LUA_TSTRING:
 				{
-					std::size_t len;
-					const char* str = lua_tolstring( ls, 2, &len);
-					bcd::BigInt operand( str, len);
+					const bcd::BigInt& operand = LuaMethods<UD>::getCachedOperand( ls, 2);
 					UD* res_ud = newuserdata( ls);
 					res_ud->init();
 					res_ud->m_value = (ud->m_value.*Method)( operand, bd->m_ar);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
 					break;
 				}
 				case LUA_TNUMBER:
@@ -505,6 +1144,7 @@ struct BitwiseBigIntLuaMethods
 					UD* res_ud = newuserdata( ls);
 					res_ud->init();
 					res_ud->m_value = (ud->m_value.*Method)( operand, bd->m_ar);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
 					break;
 				}
 				case LUA_TUSERDATA:
@@ -513,6 +1153,7 @@ struct BitwiseBigIntLuaMethods
 					UD* res_ud = newuserdata( ls);
 					res_ud->init();
 					res_ud->m_value = (ud->m_value.*Method)( operand_ud->m_value, bd->m_ar);
+					BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
 					break;
 				}
 				default:
@@ -529,6 +1170,7 @@ struct BitwiseBigIntLuaMethods
 		try
 		{
 			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			BCD_METHOD_PROBE_SCOPE( functionName, ud->m_value.nof_elements(), 0);
 			int nn = lua_gettop( ls);
 			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
 			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
@@ -537,6 +1179,7 @@ struct BitwiseBigIntLuaMethods
 			UD* res_ud = newuserdata( ls);
 			res_ud->init();
 			res_ud->m_value = (ud->m_value.*Method)( bd->m_ar);
+			BCD_METHOD_PROBE_RESULT( &res_ud->m_value);
 		}
 		catch (...) { lippincottFunction( ls); }
 		return 1;
@@ -560,15 +1203,624 @@ struct BitwiseBigIntLuaMethods
 	}
 };
 
-static const struct luaL_Reg bcd_bits_methods[] = {
-	{ "__gc",		bcd_bits_gc },
-	{ nullptr,		nullptr }
-};
+struct bcd_vector_userdata_t
+{
+public:
+	typedef bcd::BigIntVector ValueType;
 
-static const struct luaL_Reg bcd_int_methods[] = {
-	{ "__gc",		LuaMethods<bcd_int_userdata_t>::gc },
-	{ "__tostring",		LuaMethods<bcd_int_userdata_t>::tostring },
+	void create( bcd::BigIntVector&& ar_)
+	{
+		new (&m_ar) bcd::BigIntVector( std::move( ar_));
+	}
+	void destroy( lua_State* ls) noexcept
+	{
+		m_ar.~ValueType();
+	}
+	static const char* metatableName() noexcept {return "bcd.vector";}
+
+	bcd::BigIntVector m_ar;
+};
+
+struct VectorLuaMethods
+{
+	typedef bcd_vector_userdata_t UD;
+	typedef bcd_int_userdata_t IntUD;
+	enum CompareOp {CompareValue,CompareLt,CompareLe,CompareEq};
+
+	static UD* testVector( lua_State* ls, int idx)
+	{
+		if (lua_type( ls, idx) != LUA_TUSERDATA || !lua_getmetatable( ls, idx)) return nullptr;
+		luaL_getmetatable( ls, UD::metatableName());
+		bool isVector = lua_rawequal( ls, -1, -2);
+		lua_pop( ls, 2);
+		return isVector ? (UD*)lua_touserdata( ls, idx) : nullptr;
+	}
+	static void pushVector( lua_State* ls, bcd::BigIntVector&& ar)
+	{
+		UD* rt = (UD*)lua_newuserdata( ls, sizeof(UD));
+		rt->create( std::move( ar));
+		luaL_getmetatable( ls, UD::metatableName());
+		lua_setmetatable( ls, -2);
+	}
+	static IntUD* pushInt( lua_State* ls)
+	{
+		chargeMemory( ls);
+		IntUD* rt = (IntUD*)lua_newuserdata( ls, sizeof(IntUD));
+		luaL_getmetatable( ls, IntUD::metatableName());
+		lua_setmetatable( ls, -2);
+		rt->init();
+		return rt;
+	}
+	static void pushInt( lua_State* ls, const bcd::BigInt& val)
+	{
+		pushInt( ls)->m_value = val;
+	}
+	static bcd::BigInt getIntArgument( lua_State* ls, int idx, const char* functionName)
+	{
+		switch (lua_type( ls, idx))
+		{
+			case LUA_TSTRING:
+			{
+				std::size_t len;
+				const char* str = lua_tolstring( ls, idx, &len);
+				return bcd::BigInt( str, len);
+			}
+			case LUA_TNUMBER:
+				return bcd::BigInt( (long)lua_tointeger( ls, idx));
+			case LUA_TUSERDATA:
+			{
+				// ... no luaL_checkudata, a Lua error would skip the destructors of the callers
+				IntUD* ud = (IntUD*)luaL_testudata( ls, idx, IntUD::metatableName());
+				if (ud) return ud->m_value;
+				break;
+			}
+		}
+		throw std::runtime_error( std::string("expected STRING,NUMBER or bcd.int as argument for ") + functionName);
+	}
+	static std::size_t getIndexArgument( lua_State* ls, int idx, const UD* ud, const char* functionName)
+	{
+		if (lua_type( ls, idx) != LUA_TNUMBER)
+		{
+			throw std::runtime_error( std::string("expected index as argument for ") + functionName);
+		}
+		long rt = lua_tointeger( ls, idx);
+		if (rt <= 0 || (std::size_t)rt > ud->m_ar.size())
+		{
+			throw std::runtime_error( std::string("index out of range in ") + functionName);
+		}
+		return rt-1;
+	}
+
+	static int create( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.vector";
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 2) != LUA_TNUMBER || lua_tointeger( ls, 2) <= 0)
+			{
+				throw std::runtime_error( std::string("expected positive number of digits as argument for ") + functionName);
+			}
+			unsigned int nofDigits = lua_tointeger( ls, 2);
+			if (lua_type( ls, 1) == LUA_TNUMBER)
+			{
+				if (lua_tointeger( ls, 1) < 0) throw std::runtime_error( std::string("expected non negative size as argument for ") + functionName);
+				pushVector( ls, bcd::BigIntVector( lua_tointeger( ls, 1), nofDigits));
+			}
+			else if (lua_type( ls, 1) == LUA_TTABLE)
+			{
+				std::size_t ii = 0, size = lua_rawlen( ls, 1);
+				bcd::BigIntVector ar( size, nofDigits);
+				for (; ii < size; ++ii)
+				{
+					lua_rawgeti( ls, 1, ii+1);
+					ar.set( ii, getIntArgument( ls, -1, functionName));
+					lua_pop( ls, 1);
+				}
+				pushVector( ls, std::move( ar));
+			}
+			else
+			{
+				throw std::runtime_error( std::string("expected size or array of numbers as argument for ") + functionName);
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int gc( lua_State* ls)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			int nn = lua_gettop( ls);
+			if (nn > 1) throw std::runtime_error("too many arguments calling __gc");
+		}
+		catch (...) { lippincottFunction( ls); }
+
+		ud->destroy( ls);
+		return 0;
+	}
+
+	static int len( lua_State* ls)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		lua_pushinteger( ls, ud->m_ar.size());
+		return 1;
+	}
+
+	static int get( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.vector:get";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			pushInt( ls, ud->m_ar.get( getIndexArgument( ls, 2, ud, functionName)));
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int set( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.vector:set";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			int nn = lua_gettop( ls);
+			if (nn < 3) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 3) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			ud->m_ar.set( getIndexArgument( ls, 2, ud, functionName), getIntArgument( ls, 3, functionName));
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 0;
+	}
+
+	static int totable( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.vector:totable";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			std::size_t ii = 0, size = ud->m_ar.size();
+			lua_createtable( ls, size, 0);
+			for (; ii < size; ++ii)
+			{
+				pushInt( ls, ud->m_ar.get( ii));
+				lua_rawseti( ls, -2, ii+1);
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int binop( lua_State* ls, const char* functionName,
+				bcd::BigIntVector (bcd::BigIntVector::*VectorMethod)( const bcd::BigIntVector&) const,
+				bcd::BigIntVector (bcd::BigIntVector::*ScalarMethod)( const bcd::BigInt&) const,
+				bool commutative)
+	{
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			UD* ud = (UD*)testVector( ls, 1);
+			UD* operand_ud = (UD*)testVector( ls, 2);
+			if (ud && operand_ud)
+			{
+				pushVector( ls, (ud->m_ar.*VectorMethod)( operand_ud->m_ar));
+			}
+			else if (ud)
+			{
+				pushVector( ls, (ud->m_ar.*ScalarMethod)( getIntArgument( ls, 2, functionName)));
+			}
+			else if (operand_ud)
+			{
+				// ... scalar as left operand, the subtraction is evaluated as negation of the vector followed by the addition
+				bcd::BigInt operand = getIntArgument( ls, 1, functionName);
+				if (commutative)
+				{
+					pushVector( ls, (operand_ud->m_ar.*ScalarMethod)( operand));
+				}
+				else
+				{
+					pushVector( ls, operand_ud->m_ar.neg().add( operand));
+				}
+			}
+			else
+			{
+				throw std::runtime_error( std::string("expected bcd.vector as argument for ") + functionName);
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int unm( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.vector:__unm";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			pushVector( ls, ud->m_ar.neg());
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int cmpop( lua_State* ls, const char* functionName, CompareOp op)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			UD* operand_ud = (UD*)testVector( ls, 2);
+			std::vector<int> res = operand_ud
+						? ud->m_ar.compare( operand_ud->m_ar)
+						: ud->m_ar.compare( getIntArgument( ls, 2, functionName));
+			std::size_t ii = 0, size = res.size();
+			lua_createtable( ls, size, 0);
+			for (; ii < size; ++ii)
+			{
+				switch (op)
+				{
+					case CompareValue: lua_pushinteger( ls, res[ ii]); break;
+					case CompareLt: lua_pushboolean( ls, res[ ii] < 0); break;
+					case CompareLe: lua_pushboolean( ls, res[ ii] <= 0); break;
+					case CompareEq: lua_pushboolean( ls, res[ ii] == 0); break;
+				}
+				lua_rawseti( ls, -2, ii+1);
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int add( lua_State* ls)
+	{
+		return binop( ls, "bcd.vector:add", &bcd::BigIntVector::add, &bcd::BigIntVector::add, true);
+	}
+	static int sub( lua_State* ls)
+	{
+		return binop( ls, "bcd.vector:sub", &bcd::BigIntVector::sub, &bcd::BigIntVector::sub, false);
+	}
+	static int mul( lua_State* ls)
+	{
+		return binop( ls, "bcd.vector:mul", &bcd::BigIntVector::mul, &bcd::BigIntVector::mul, true);
+	}
+	static int compare( lua_State* ls)
+	{
+		return cmpop( ls, "bcd.vector:compare", CompareValue);
+	}
+	static int lt( lua_State* ls)
+	{
+		return cmpop( ls, "bcd.vector:lt", CompareLt);
+	}
+	static int le( lua_State* ls)
+	{
+		return cmpop( ls, "bcd.vector:le", CompareLe);
+	}
+	static int eq( lua_State* ls)
+	{
+		return cmpop( ls, "bcd.vector:eq", CompareEq);
+	}
+};
+
+struct bcd_expr_userdata_t
+{
+public:
+	typedef std::shared_ptr<bcd::ExpressionGraph> GraphRef;
+
+	void create( const GraphRef& graph, bcd::ExpressionGraph::NodeIndex node) noexcept
+	{
+		new (&m_graph) GraphRef( graph);
+		new (&m_compiled) std::unique_ptr<bcd::CompiledExpression>();
+		m_node = node;
+	}
+	void destroy( lua_State* ls) noexcept
+	{
+		m_compiled.~unique_ptr();
+		m_graph.~GraphRef();
+	}
+	static const char* metatableName() noexcept {return "bcd.expr";}
+
+	GraphRef m_graph;						///< graph shared by all expressions built from the same call of bcd.expr
+	bcd::ExpressionGraph::NodeIndex m_node;				///< root node of the expression
+	std::unique_ptr<bcd::CompiledExpression> m_compiled;		///< compiled on the first evaluation
+};
+
+struct ExpressionLuaMethods
+{
+	typedef bcd_expr_userdata_t UD;
+	typedef bcd_int_userdata_t IntUD;
+	typedef bcd::ExpressionGraph::NodeIndex NodeIndex;
+
+	static UD* testExpression( lua_State* ls, int idx) noexcept
+	{
+		if (lua_type( ls, idx) != LUA_TUSERDATA || !lua_getmetatable( ls, idx)) return nullptr;
+		luaL_getmetatable( ls, UD::metatableName());
+		bool isExpr = lua_rawequal( ls, -1, -2);
+		lua_pop( ls, 2);
+		return isExpr ? (UD*)lua_touserdata( ls, idx) : nullptr;
+	}
+	// Push the userdata of a new expression, allocated before any C++ object is created, a Lua allocation error would skip their destructors
+	static void pushNewExpression( lua_State* ls)
+	{
+		lua_newuserdata( ls, sizeof(UD));
+	}
+	// Create the expression in the userdata at the absolute index 'idx' pushed with pushNewExpression
+	static void createExpression( lua_State* ls, int idx, const UD::GraphRef& graph, NodeIndex node) noexcept
+	{
+		UD* ud = (UD*)lua_touserdata( ls, idx);
+		ud->create( graph, node);
+		luaL_getmetatable( ls, UD::metatableName());
+		lua_setmetatable( ls, idx);
+	}
+	// Get the node of the operand at 'idx', numbers are added to the graph as constants
+	static NodeIndex getOperandNode( lua_State* ls, int idx, const UD::GraphRef& graph, const char* functionName)
+	{
+		UD* ud = testExpression( ls, idx);
+		if (ud)
+		{
+			if (ud->m_graph != graph) throw std::runtime_error( std::string("operands not built from the same call of bcd.expr in ") + functionName);
+			return ud->m_node;
+		}
+		return graph->constant( VectorLuaMethods::getIntArgument( ls, idx, functionName));
+	}
+	// Get the argument of an evaluation at 'idx', a bcd.int is referenced, values converted from STRING or NUMBER are stored in 'buf'
+	static const bcd::BigInt* getEvalArgument( lua_State* ls, int idx, const char* functionName, std::deque<bcd::BigInt>& buf)
+	{
+		if (lua_type( ls, idx) == LUA_TUSERDATA)
+		{
+			IntUD* ud = (IntUD*)luaL_testudata( ls, idx, IntUD::metatableName());
+			if (!ud) throw std::runtime_error( std::string("expected STRING,NUMBER or bcd.int as argument for ") + functionName);
+			return &ud->m_value;
+		}
+		buf.push_back( VectorLuaMethods::getIntArgument( ls, idx, functionName));
+		return &buf.back();
+	}
+	static bcd::CompiledExpression& compiled( UD* ud)
+	{
+		if (!ud->m_compiled) ud->m_compiled.reset( new bcd::CompiledExpression( *ud->m_graph, ud->m_node));
+		return *ud->m_compiled;
+	}
+
+	static int create( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.expr";
+		try
+		{
+			int nn = lua_gettop( ls);
+			if (nn < 1) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 1) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 1) != LUA_TNUMBER || lua_tointeger( ls, 1) <= 0)
+			{
+				throw std::runtime_error( std::string("expected positive number of arguments as argument for ") + functionName);
+			}
+			std::size_t nofArguments = lua_tointeger( ls, 1);
+			if (nofArguments > 256 || !lua_checkstack( ls, nofArguments + 2))
+			{
+				throw std::runtime_error( std::string("too many arguments of expression in ") + functionName);
+			}
+			for (std::size_t ai = 0; ai < nofArguments; ++ai)
+			{
+				pushNewExpression( ls);
+			}
+			UD::GraphRef graph = std::make_shared<bcd::ExpressionGraph>( nofArguments);
+			for (std::size_t ai = 0; ai < nofArguments; ++ai)
+			{
+				createExpression( ls, nn + 1 + ai, graph, ai);
+			}
+			return nofArguments;
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 0;
+	}
+
+	static int gc( lua_State* ls)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		ud->destroy( ls);
+		return 0;
+	}
+
+	static int tostring( lua_State* ls)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			std::string val = ud->m_graph->tostring( ud->m_node);
+			lua_pushlstring( ls, val.c_str(), val.size());
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int binop( lua_State* ls, const char* functionName, bcd::ExpressionOp op)
+	{
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			// ... called with the bcd.expr as first or as second operand
+			UD* ud = testExpression( ls, 1);
+			if (!ud) ud = testExpression( ls, 2);
+			if (!ud) throw std::runtime_error( std::string("expected bcd.expr as argument for ") + functionName);
+			pushNewExpression( ls);
+			const UD::GraphRef& graph = ud->m_graph;
+			NodeIndex arg1 = getOperandNode( ls, 1, graph, functionName);
+			NodeIndex arg2 = getOperandNode( ls, 2, graph, functionName);
+			createExpression( ls, nn + 1, graph, graph->operation( op, arg1, arg2));
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int unm( lua_State* ls)
+	{
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			pushNewExpression( ls);
+			createExpression( ls, lua_gettop( ls), ud->m_graph, ud->m_graph->operation( bcd::ExpressionOp::Neg, ud->m_node, 0));
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int eval( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.expr:eval";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 3)) throw std::bad_alloc();
+			bcd::CompiledExpression& expr = compiled( ud);
+			int nn = lua_gettop( ls);
+			if ((std::size_t)(nn-1) < expr.nofArguments()) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if ((std::size_t)(nn-1) > expr.nofArguments()) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			// ... the result is allocated before the C++ objects, a Lua allocation error would skip their destructors
+			IntUD* rt = VectorLuaMethods::pushInt( ls);
+			std::deque<bcd::BigInt> buf;
+			std::vector<const bcd::BigInt*> args;
+			for (int ai = 2; ai <= nn; ++ai)
+			{
+				args.push_back( getEvalArgument( ls, ai, functionName, buf));
+			}
+			rt->m_value = expr.evaluate( args.data());
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int map( lua_State* ls)
+	{
+		[[maybe_unused]] static const char* functionName = "bcd.expr:map";
+		UD* ud = (UD*)luaL_checkudata( ls, 1, UD::metatableName());
+		try
+		{
+			if (!lua_checkstack( ls, 6)) throw std::bad_alloc();
+			int nn = lua_gettop( ls);
+			if (nn < 2) throw std::runtime_error( std::string("too few arguments calling ") + functionName);
+			if (nn > 2) throw std::runtime_error( std::string("too many arguments calling ") + functionName);
+			if (lua_type( ls, 2) != LUA_TTABLE)
+			{
+				throw std::runtime_error( std::string("expected array of argument lists as argument for ") + functionName);
+			}
+			bcd::CompiledExpression& expr = compiled( ud);
+			std::size_t ii = 0, size = lua_rawlen( ls, 2);
+			lua_createtable( ls, size, 0);
+			for (; ii < size; ++ii)
+			{
+				lua_rawgeti( ls, 2, ii+1);
+				// ... the result is allocated before the C++ objects, a Lua allocation error would skip their destructors
+				IntUD* rt = VectorLuaMethods::pushInt( ls);
+				{
+					std::deque<bcd::BigInt> buf;
+					std::vector<const bcd::BigInt*> args;
+					// ... the arguments of an expression with one argument may be passed without array
+					if (lua_type( ls, -2) != LUA_TTABLE && expr.nofArguments() == 1)
+					{
+						args.push_back( getEvalArgument( ls, -2, functionName, buf));
+					}
+					else if (lua_type( ls, -2) == LUA_TTABLE && lua_rawlen( ls, -2) == expr.nofArguments())
+					{
+						for (std::size_t ai = 0; ai < expr.nofArguments(); ++ai)
+						{
+							// ... the value stays referenced by the table after popping it from the stack
+							lua_rawgeti( ls, -2, ai+1);
+							args.push_back( getEvalArgument( ls, -1, functionName, buf));
+							lua_pop( ls, 1);
+						}
+					}
+					else
+					{
+						throw std::runtime_error( std::string("expected list of as many arguments as the expression has in ") + functionName);
+					}
+					rt->m_value = expr.evaluate( args.data());
+				}
+				lua_rawseti( ls, -3, ii+1);
+				lua_pop( ls, 1);
+			}
+		}
+		catch (...) { lippincottFunction( ls); }
+		return 1;
+	}
+
+	static int add( lua_State* ls)
+	{
+		return binop( ls, "bcd.expr:__add", bcd::ExpressionOp::Add);
+	}
+	static int sub( lua_State* ls)
+	{
+		return binop( ls, "bcd.expr:__sub", bcd::ExpressionOp::Sub);
+	}
+	static int mul( lua_State* ls)
+	{
+		return binop( ls, "bcd.expr:__mul", bcd::ExpressionOp::Mul);
+	}
+	static int div( lua_State* ls)
+	{
+		return binop( ls, "bcd.expr:__div", bcd::ExpressionOp::Div);
+	}
+	static int mod( lua_State* ls)
+	{
+		return binop( ls, "bcd.expr:__mod", bcd::ExpressionOp::Mod);
+	}
+};
+
+static bool isExpression( lua_State* ls, int idx) noexcept
+{
+	return ExpressionLuaMethods::testExpression( ls, idx) != nullptr;
+}
+
+static int expressionOperation( lua_State* ls, const char* functionName, bcd::TraceOp traceOp)
+{
+	switch (traceOp)
+	{
+		case bcd::TraceOp::Add: return ExpressionLuaMethods::add( ls);
+		case bcd::TraceOp::Sub: return ExpressionLuaMethods::sub( ls);
+		case bcd::TraceOp::Mul: return ExpressionLuaMethods::mul( ls);
+		case bcd::TraceOp::Div: return ExpressionLuaMethods::div( ls);
+		case bcd::TraceOp::Mod: return ExpressionLuaMethods::mod( ls);
+		default: break;
+	}
+	return luaL_error( ls, "bcd.expr not supported as operand of %s", functionName);
+}
+
+static const struct luaL_Reg bcd_bits_methods[] = {
+	{ "__gc",		bcd_bits_gc },
+	{ nullptr,		nullptr }
+};
+
+static const struct luaL_Reg bcd_int_methods[] = {
+	{ "__gc",		LuaMethods<bcd_int_userdata_t>::gc },
+	{ "__close",		LuaMethods<bcd_int_userdata_t>::release },
+	{ "free",		LuaMethods<bcd_int_userdata_t>::release },
+	{ "__tostring",		LuaMethods<bcd_int_userdata_t>::tostring },
 	{ "tonumber",		LuaMethods<bcd_int_userdata_t>::tonumber },
+	{ "save",		LuaMethods<bcd_int_userdata_t>::save },
+	{ "write",		LuaMethods<bcd_int_userdata_t>::write },
+	{ "pack",		LuaMethods<bcd_int_userdata_t>::pack },
 	{ "__add",		LuaMethods<bcd_int_userdata_t>::add },
 	{ "__sub",		LuaMethods<bcd_int_userdata_t>::sub },
 	{ "__mul",		LuaMethods<bcd_int_userdata_t>::mul },
@@ -577,12 +1829,49 @@ static const struct luaL_Reg bcd_int_methods[] = {
 	{ "__mod",		LuaMethods<bcd_int_userdata_t>::mod },
 	{ "__unm",		LuaMethods<bcd_int_userdata_t>::unm },
 	{ "__pow",		LuaMethods<bcd_int_userdata_t>::pow },
+	{ "isqrt",		LuaMethods<bcd_int_userdata_t>::isqrt },
+	{ "iroot",		LuaMethods<bcd_int_userdata_t>::iroot },
 	{ "__lt",		LuaMethods<bcd_int_userdata_t>::lt },
 	{ "__le",		LuaMethods<bcd_int_userdata_t>::le },
 	{ "__eq",		LuaMethods<bcd_int_userdata_t>::eq },
 	{ nullptr,		nullptr }
 };
 
+static const struct luaL_Reg bcd_vector_methods[] = {
+	{ "__gc",		VectorLuaMethods::gc },
+	{ "__len",		VectorLuaMethods::len },
+	{ "__add",		VectorLuaMethods::add },
+	{ "__sub",		VectorLuaMethods::sub },
+	{ "__mul",		VectorLuaMethods::mul },
+	{ "__unm",		VectorLuaMethods::unm },
+	{ "add",		VectorLuaMethods::add },
+	{ "sub",		VectorLuaMethods::sub },
+	{ "mul",		VectorLuaMethods::mul },
+	{ "neg",		VectorLuaMethods::unm },
+	{ "get",		VectorLuaMethods::get },
+	{ "set",		VectorLuaMethods::set },
+	{ "totable",		VectorLuaMethods::totable },
+	{ "compare",		VectorLuaMethods::compare },
+	{ "lt",			VectorLuaMethods::lt },
+	{ "le",			VectorLuaMethods::le },
+	{ "eq",			VectorLuaMethods::eq },
+	{ nullptr,		nullptr }
+};
+
+static const struct luaL_Reg bcd_expr_methods[] = {
+	{ "__gc",		ExpressionLuaMethods::gc },
+	{ "__tostring",		ExpressionLuaMethods::tostring },
+	{ "__add",		ExpressionLuaMethods::add },
+	{ "__sub",		ExpressionLuaMethods::sub },
+	{ "__mul",		ExpressionLuaMethods::mul },
+	{ "__div",		ExpressionLuaMethods::div },
+	{ "__mod",		ExpressionLuaMethods::mod },
+	{ "__unm",		ExpressionLuaMethods::unm },
+	{ "eval",		ExpressionLuaMethods::eval },
+	{ "map",		ExpressionLuaMethods::map },
+	{ nullptr,		nullptr }
+};
+
 static const struct luaL_Reg bcd_int_bitwise_methods[] = {
 	{"bit_and",		BitwiseBigIntLuaMethods::bitwise_and },
 	{"bit_or",		BitwiseBigIntLuaMethods::bitwise_or },
@@ -594,6 +1883,22 @@ static const struct luaL_Reg bcd_int_bitwise_methods[] = {
 static const struct luaL_Reg bcd_functions[] = {
 	{ "int",		LuaMethods<bcd_int_userdata_t>::create },
 	{ "bits",		bcd_bits_create },
+	{ "vector",		VectorLuaMethods::create },
+	{ "expr",		ExpressionLuaMethods::create },
+	{ "load",		LuaMethods<bcd_int_userdata_t>::load },
+	{ "unpack",		LuaMethods<bcd_int_userdata_t>::unpack },
+	{ "factorial",		LuaMethods<bcd_int_userdata_t>::factorial },
+	{ "binomial",		LuaMethods<bcd_int_userdata_t>::binomial },
+	{ "product",		LuaMethods<bcd_int_userdata_t>::product },
+	{ "prod",		LuaMethods<bcd_int_userdata_t>::product },
+	{ "sum",		LuaMethods<bcd_int_userdata_t>::sum },
+	{ "dot",		LuaMethods<bcd_int_userdata_t>::dot },
+	{ "set_threads",	bcd_set_threads },
+	{ "memory",		bcd_memory },
+	{ "stats",		bcd_stats },
+	{ "stats_reset",	bcd_stats_reset },
+	{ "trace_start",	bcd_trace_start },
+	{ "trace_stop",		bcd_trace_stop },
 	{ nullptr,  		nullptr }
 };
 
@@ -605,6 +1910,31 @@ static void createMetatable( lua_State* ls, const char* metatableName, const str
 	luaL_setfuncs( ls, metatableMethods, 0);
 }
 
+static void createOperandCache( lua_State* ls)
+{
+	lua_newtable( ls);
+	lua_newtable( ls);
+	lua_pushliteral( ls, "v");
+	lua_setfield( ls, -2, "__mode");
+	lua_setmetatable( ls, -2);
+	lua_setfield( ls, LUA_REGISTRYINDEX, g_operandCacheName);
+}
+
+static void bindAllocator( lua_State* ls)
+{
+	// ... only an allocator not depending on data of the state can be shared by the numbers of all states,
+	//	it is bound once before any number is allocated, so that no elements are freed by another allocator
+	static std::once_flag once;
+	void* allocContext = nullptr;
+	lua_Alloc allocFunction = lua_getallocf( ls, &allocContext);
+	if (!allocContext)
+	{
+		std::call_once( once, [allocFunction]{
+			if (bcd::BigInt::memoryInUse() == 0) bcd::BigInt::setAllocator( allocFunction, nullptr);
+		});
+	}
+}
+
 extern "C" int luaopen_bcd( lua_State* ls);
 
 DLL_PUBLIC int luaopen_bcd( lua_State* ls)
@@ -613,6 +1943,10 @@ DLL_PUBLIC int luaopen_bcd( lua_State* ls)
 	luaL_setfuncs( ls, bcd_int_bitwise_methods, 0);
 
 	createMetatable( ls, bcd_bits_userdata_t::metatableName(), bcd_bits_methods);
+	createMetatable( ls, bcd_vector_userdata_t::metatableName(), bcd_vector_methods);
+	createMetatable( ls, bcd_expr_userdata_t::metatableName(), bcd_expr_methods);
+	createOperandCache( ls);
+	bindAllocator( ls);
 
 	luaL_newlib( ls, bcd_functions);
 	return 1;
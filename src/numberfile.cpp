@@ -0,0 +1,144 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file numberfile.cpp
+///\brief Implements the reading and writing of numbers in files
+#include "numberfile.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define NumberWriteBufferSize 65536
+#define NumDigits 15
+
+using namespace bcd;
+
+// ... read only mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+public:
+	explicit MappedFile( const std::string& path)
+		:m_data(nullptr),m_size(0)
+	{
+		int fd = ::open( path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error( std::string("failed to open number file ") + path + ": " + std::strerror( errno));
+		struct stat st;
+		if (0 != ::fstat( fd, &st))
+		{
+			int ec = errno;
+			::close( fd);
+			throw std::runtime_error( std::string("failed to open number file ") + path + ": " + std::strerror( ec));
+		}
+		m_size = st.st_size;
+		if (m_size)
+		{
+			// ... the mapping stays valid after closing the file descriptor
+			void* data = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			int ec = errno;
+			::close( fd);
+			if (data == MAP_FAILED) throw std::runtime_error( std::string("failed to map number file ") + path + ": " + std::strerror( ec));
+			m_data = (const char*)data;
+			::madvise( data, m_size, MADV_SEQUENTIAL);
+		}
+		else
+		{
+			::close( fd);
+		}
+	}
+	~MappedFile()
+	{
+		if (m_data) ::munmap( (void*)m_data, m_size);
+	}
+	MappedFile( const MappedFile&) = delete;
+	MappedFile& operator=( const MappedFile&) = delete;
+
+	const char* data() const noexcept	{return m_data;}
+	std::size_t size() const noexcept	{return m_size;}
+
+private:
+	const char* m_data;
+	std::size_t m_size;
+};
+
+static bool is_space( char ch) noexcept
+{
+	return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+BigInt bcd::loadNumber( const std::string& path)
+{
+	MappedFile file( path);
+	const char* start = file.data();
+	const char* end = start + file.size();
+	for (; start != end && is_space( *start); ++start){}
+	for (; end != start && is_space( *(end-1)); --end){}
+	return BigInt( start, end - start);
+}
+
+// ... writes the digits of an element, 'nofDigits' low order digits of it
+static char* format_element( char* dest, BigInt::Element elem, int nofDigits) noexcept
+{
+	for (int di = nofDigits; di > 0; --di)
+	{
+		*dest++ = '0' + (char)((elem >> ((di-1) * 4)) & 0xf);
+	}
+	return dest;
+}
+
+void bcd::writeNumber( std::FILE* file, const BigInt& num)
+{
+	char buf[ NumberWriteBufferSize];
+	std::size_t pos = 0;
+	std::size_t ei = num.nof_elements();
+	const BigInt::Element* ar = num.elements();
+	auto flush = [&]()
+	{
+		if (pos && std::fwrite( buf, 1, pos, file) != pos) throw std::runtime_error( std::string("failed to write number: ") + std::strerror( errno));
+		pos = 0;
+	};
+	if (!ei)
+	{
+		buf[ pos++] = '0';
+	}
+	else
+	{
+		if (num.sign() == '-') buf[ pos++] = '-';
+		// ... the highest element without leading zeros
+		int nofDigits = 1;
+		for (BigInt::Element top = ar[ ei-1]; top >= 16; top >>= 4) ++nofDigits;
+		pos = format_element( buf + pos, ar[ --ei], nofDigits) - buf;
+		while (ei)
+		{
+			if (pos + NumDigits > sizeof(buf)) flush();
+			pos = format_element( buf + pos, ar[ --ei], NumDigits) - buf;
+		}
+	}
+	flush();
+}
+
+void bcd::saveNumber( const std::string& path, const BigInt& num)
+{
+	std::FILE* file = std::fopen( path.c_str(), "wb");
+	if (!file) throw std::runtime_error( std::string("failed to create number file ") + path + ": " + std::strerror( errno));
+	try
+	{
+		writeNumber( file, num);
+	}
+	catch (...)
+	{
+		std::fclose( file);
+		throw;
+	}
+	if (0 != std::fclose( file)) throw std::runtime_error( std::string("failed to close number file ") + path);
+}
+
@@ -0,0 +1,32 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file numberfile.hpp
+///\brief Reading and writing of numbers as decimal digits in files without intermediate strings
+#ifndef _BCD_NUMBERFILE_HPP_INCLUDED
+#define _BCD_NUMBERFILE_HPP_INCLUDED
+#include "bcd.hpp"
+#include <string>
+#include <cstdio>
+
+namespace bcd {
+
+/// \brief Load a number from a file containing its decimal digits, surrounded by white space
+/// \remark The file is mapped into memory and its digits are packed directly into the elements of the result
+BigInt loadNumber( const std::string& path);
+
+/// \brief Write the decimal digits of a number to a file through a buffer of fixed size
+void writeNumber( std::FILE* file, const BigInt& num);
+
+/// \brief Write the decimal digits of a number to a file created or truncated
+void saveNumber( const std::string& path, const BigInt& num);
+
+}//namespace
+#endif
+
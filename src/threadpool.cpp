@@ -0,0 +1,229 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file threadpool.cpp
+///\brief Implements the work stealing thread pool
+
+#include "threadpool.hpp"
+
+using namespace bcd;
+
+ThreadPool::ThreadPool()
+	:m_nofQueued(0)
+	,m_nextQueue(0)
+	,m_nofThreads(1)
+	,m_nofRunning(0)
+	,m_reconfiguring(false)
+	,m_terminate(false)
+{}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool rt;
+	return rt;
+}
+
+void ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_terminate = true;
+	}
+	m_cond.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+	m_queues.clear();
+	m_terminate = false;
+	m_nofThreads = 1;
+}
+
+void ThreadPool::setNofThreads( unsigned int nofThreads)
+{
+	// ... reconfigurations are serialized and wait for the task lists in process, the pool is shared by all threads of the process
+	std::lock_guard<std::mutex> configLock( m_configMutex);
+	{
+		std::unique_lock<std::mutex> lock( m_mutex);
+		m_reconfiguring = true;
+		m_idle.wait( lock, [this]{return m_nofRunning == 0;});
+	}
+	try
+	{
+		stop();
+		start( nofThreads);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_reconfiguring = false;
+		throw;
+	}
+	std::lock_guard<std::mutex> lock( m_mutex);
+	m_reconfiguring = false;
+}
+
+void ThreadPool::start( unsigned int nofThreads)
+{
+	if (nofThreads <= 1) return;
+
+	// ... the caller of run is the thread processing the tasks together with nofThreads-1 workers
+	std::size_t qi = 0, qe = nofThreads-1;
+	for (; qi != qe; ++qi)
+	{
+		m_queues.emplace_back( new WorkerQueue());
+	}
+	try
+	{
+		for (qi = 0; qi != qe; ++qi)
+		{
+			m_threads.emplace_back( &ThreadPool::workerLoop, this, qi);
+		}
+	}
+	catch (...)
+	{
+		stop();
+		throw;
+	}
+	m_nofThreads = nofThreads;
+}
+
+bool ThreadPool::popOwnTask( std::size_t queueidx, QueueItem& item)
+{
+	WorkerQueue& queue = *m_queues[ queueidx];
+	std::lock_guard<std::mutex> lock( queue.mutex);
+	if (queue.items.empty()) return false;
+	item = queue.items.back();
+	queue.items.pop_back();
+	--m_nofQueued;
+	return true;
+}
+
+bool ThreadPool::stealTask( std::size_t queueidx, QueueItem& item)
+{
+	std::size_t qi = 0, qe = m_queues.size();
+	for (; qi != qe; ++qi)
+	{
+		WorkerQueue& queue = *m_queues[ (queueidx + qi) % qe];
+		std::lock_guard<std::mutex> lock( queue.mutex);
+		if (queue.items.empty()) continue;
+		item = queue.items.front();
+		queue.items.pop_front();
+		--m_nofQueued;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::execute( QueueItem& item) noexcept
+{
+	TaskGroup* group = item.group;
+	try
+	{
+		(*item.task)();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock( group->mutex);
+		if (!group->error) group->error = std::current_exception();
+	}
+	// ... last access to the group, the caller of run may return after the mutex is released
+	std::lock_guard<std::mutex> lock( group->mutex);
+	if (--group->pending == 0) group->done.notify_all();
+}
+
+void ThreadPool::workerLoop( std::size_t queueidx)
+{
+	QueueItem item;
+	for (;;)
+	{
+		if (popOwnTask( queueidx, item) || stealTask( queueidx + 1, item))
+		{
+			execute( item);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( m_mutex);
+		m_cond.wait( lock, [this]{return m_terminate || m_nofQueued > 0;});
+		if (m_terminate) return;
+	}
+}
+
+bool ThreadPool::beginRun()
+{
+	std::lock_guard<std::mutex> lock( m_mutex);
+	// ... no new task lists are queued while the pool is reconfigured, including the ones issued by tasks in process
+	if (m_reconfiguring || m_queues.empty()) return false;
+	++m_nofRunning;
+	return true;
+}
+
+void ThreadPool::endRun()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		--m_nofRunning;
+	}
+	m_idle.notify_all();
+}
+
+void ThreadPool::run( std::vector<Task>& tasks)
+{
+	if (tasks.size() <= 1 || !beginRun())
+	{
+		for (auto& task : tasks) task();
+		return;
+	}
+	TaskGroup group;
+	group.pending = tasks.size();
+	std::size_t ti = 0;
+	try
+	{
+		for (; ti < tasks.size(); ++ti)
+		{
+			WorkerQueue& queue = *m_queues[ m_nextQueue++ % m_queues.size()];
+			std::lock_guard<std::mutex> lock( queue.mutex);
+			queue.items.push_back( QueueItem{ &tasks[ ti], &group});
+			++m_nofQueued;
+		}
+	}
+	catch (...)
+	{
+		// ... the tasks that could not be queued are processed by the caller
+		for (; ti < tasks.size(); ++ti)
+		{
+			QueueItem item{ &tasks[ ti], &group};
+			execute( item);
+		}
+	}
+	{
+		// ... synchronize with workers checking the wait condition to not miss the notification
+		std::lock_guard<std::mutex> lock( m_mutex);
+	}
+	m_cond.notify_all();
+
+	// ... help while tasks are queued, then sleep until the workers finished the tasks in process
+	QueueItem item;
+	while (group.pending > 0 && stealTask( 0, item))
+	{
+		execute( item);
+	}
+	{
+		std::unique_lock<std::mutex> lock( group.mutex);
+		group.done.wait( lock, [&group]{return group.pending == 0;});
+	}
+	endRun();
+	if (group.error) std::rethrow_exception( group.error);
+}
+
@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file threadpool.hpp
+///\brief Work stealing thread pool for splitting operations on very large numbers
+#ifndef _BCD_THREADPOOL_HPP_INCLUDED
+#define _BCD_THREADPOOL_HPP_INCLUDED
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace bcd {
+
+///\class ThreadPool
+///\brief Pool of worker threads, each with its own task queue, stealing tasks from the other queues when idle
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	/// \brief Get the pool shared by all operations of the library
+	static ThreadPool& instance();
+	/// \brief Destructor, joins all worker threads
+	~ThreadPool();
+
+	/// \brief Set the number of threads processing a task list including the caller of run
+	/// \note Waits until the task lists in process are completed, task lists passed to run meanwhile are processed by the caller alone
+	/// \param[in] nofThreads number of threads, 0 or 1 for processing all tasks sequentially by the caller
+	void setNofThreads( unsigned int nofThreads);
+	/// \brief Get the number of threads processing a task list including the caller of run
+	/// \return the number of threads, 1 if there are no workers
+	unsigned int nofThreads() const noexcept			{return m_nofThreads;}
+
+	/// \brief Process a list of tasks and wait until all are completed, the calling thread participates
+	/// \note Rethrows the first exception thrown by a task after all tasks are completed
+	void run( std::vector<Task>& tasks);
+
+private:
+	ThreadPool();
+	ThreadPool( const ThreadPool&) = delete;
+	void operator=( const ThreadPool&) = delete;
+
+	struct TaskGroup
+	{
+		std::atomic<std::size_t> pending;
+		std::mutex mutex;
+		std::condition_variable done;	///< signalled when pending reaches 0
+		std::exception_ptr error;
+	};
+	struct QueueItem
+	{
+		Task* task;
+		TaskGroup* group;
+	};
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<QueueItem> items;
+	};
+
+	bool popOwnTask( std::size_t queueidx, QueueItem& item);
+	bool stealTask( std::size_t queueidx, QueueItem& item);
+	static void execute( QueueItem& item) noexcept;
+	void workerLoop( std::size_t queueidx);
+	void start( unsigned int nofThreads);
+	void stop();
+	bool beginRun();
+	void endRun();
+
+private:
+	std::vector<std::unique_ptr<WorkerQueue> > m_queues;
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::condition_variable m_idle;
+	std::mutex m_configMutex;
+	std::atomic<std::size_t> m_nofQueued;
+	std::atomic<std::size_t> m_nextQueue;
+	std::atomic<unsigned int> m_nofThreads;
+	std::size_t m_nofRunning;
+	bool m_reconfiguring;
+	bool m_terminate;
+};
+
+}//namespace
+#endif
+
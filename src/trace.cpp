@@ -0,0 +1,299 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file trace.cpp
+///\brief Implements the writer and the reader of trace files
+///\remark Format: header "BCDTRACE", version byte, flags byte (1 = elements recorded), then the records.
+///	Record: operation code byte, number of operands byte, operands.
+///	Operand: kind byte (0 = positive number, 1 = negative number, 2 = integer),
+///	number: number of elements as varint followed by the elements as 64 bit words or by a 64 bit hash of them,
+///	integer: value as zigzag encoded varint. Varints are LEB128, words little endian.
+#include "trace.hpp"
+#include <random>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#define TraceMagic "BCDTRACE"
+#define TraceVersion 1
+#define TraceFlagValues 1
+#define TraceBufferSize 65536
+#define ElementBase 1000000000000000ULL
+
+using namespace bcd;
+using namespace bcd::detail;
+
+static const char* g_traceOpNames[ NofTraceOps] = {
+	"parse", "tostring", "add", "sub", "mul", "div", "mod", "pow", "neg", "compare", "iroot", "save", "write"
+};
+
+const char* bcd::traceOpName( TraceOp op) noexcept
+{
+	return (std::size_t)op < NofTraceOps ? g_traceOpNames[ (std::size_t)op] : "unknown";
+}
+
+static std::uint64_t hash_elements( const BigInt::Element* ar, std::size_t size) noexcept
+{
+	// ... FNV-1a over the elements
+	std::uint64_t rt = 14695981039346656037ULL;
+	for (std::size_t ii = 0; ii < size; ++ii)
+	{
+		rt = (rt ^ ar[ ii]) * 1099511628211ULL;
+	}
+	return rt;
+}
+
+BigInt TraceOperand::number() const
+{
+	if (isInteger) return BigInt( integer);
+	if (!elements.empty() || size == 0)
+	{
+		// ... copied from a constant referencing the elements, a copy owns its elements
+		BigInt ref = BigInt::constant( elements.data(), elements.size(), sign);
+		return BigInt( ref);
+	}
+	// ... the same hash gives the same number, so operands used repeatedly stay equal
+	std::mt19937_64 rnd( hash);
+	std::vector<BigInt::Element> ar( size);
+	for (std::size_t ii = 0; ii < size; ++ii)
+	{
+		ar[ ii] = uint_to_bcd( rnd() % ElementBase);
+	}
+	if (ar[ size-1] == 0) ar[ size-1] = 1;
+	BigInt ref = BigInt::constant( ar.data(), ar.size(), sign);
+	return BigInt( ref);
+}
+
+TraceWriter::TraceWriter( const std::string& path, bool withValues)
+	:m_path(path),m_file(std::fopen( path.c_str(), "wb")),m_buf(),m_withValues(withValues)
+{
+	if (!m_file) throw std::runtime_error( std::string("failed to create trace file ") + path + ": " + std::strerror( errno));
+	m_buf.reserve( TraceBufferSize);
+	m_buf.insert( m_buf.end(), TraceMagic, TraceMagic + std::strlen( TraceMagic));
+	m_buf.push_back( TraceVersion);
+	m_buf.push_back( withValues ? TraceFlagValues : 0);
+}
+
+TraceWriter::~TraceWriter()
+{
+	if (m_file)
+	{
+		try {flush();} catch (...) {}
+		std::fclose( m_file);
+	}
+}
+
+static void append_varint( std::vector<unsigned char>& buf, std::uint64_t val)
+{
+	while (val >= 0x80)
+	{
+		buf.push_back( (unsigned char)(val & 0x7f) | 0x80);
+		val >>= 7;
+	}
+	buf.push_back( (unsigned char)val);
+}
+
+static void append_word( std::vector<unsigned char>& buf, std::uint64_t val)
+{
+	for (int ii = 0; ii < 8; ++ii, val >>= 8) buf.push_back( (unsigned char)(val & 0xff));
+}
+
+void TraceWriter::writeHeader( TraceOp op, std::size_t nofOperands)
+{
+	if (!m_file) throw std::runtime_error( "write to closed trace file");
+	if (m_buf.size() >= TraceBufferSize) flush();
+	m_buf.push_back( (unsigned char)op);
+	m_buf.push_back( (unsigned char)nofOperands);
+}
+
+void TraceWriter::writeNumber( const BigInt& opr)
+{
+	m_buf.push_back( opr.sign() == '-' ? 1 : 0);
+	append_varint( m_buf, opr.nof_elements());
+	if (m_withValues)
+	{
+		for (std::size_t ii = 0; ii < opr.nof_elements(); ++ii) append_word( m_buf, opr.elements()[ ii]);
+	}
+	else
+	{
+		append_word( m_buf, hash_elements( opr.elements(), opr.nof_elements()));
+	}
+}
+
+void TraceWriter::writeInteger( long opr)
+{
+	m_buf.push_back( 2);
+	append_varint( m_buf, ((std::uint64_t)opr << 1) ^ (std::uint64_t)(opr >> 63));
+}
+
+void TraceWriter::write( TraceOp op, const BigInt& opr)
+{
+	writeHeader( op, 1);
+	writeNumber( opr);
+}
+
+void TraceWriter::write( TraceOp op, const BigInt& opr1, const BigInt& opr2)
+{
+	writeHeader( op, 2);
+	writeNumber( opr1);
+	writeNumber( opr2);
+}
+
+void TraceWriter::write( TraceOp op, const BigInt& opr1, long opr2)
+{
+	writeHeader( op, 2);
+	writeNumber( opr1);
+	writeInteger( opr2);
+}
+
+void TraceWriter::flush()
+{
+	if (!m_buf.empty() && std::fwrite( m_buf.data(), 1, m_buf.size(), m_file) != m_buf.size())
+	{
+		m_buf.clear();
+		throw std::runtime_error( std::string("failed to write trace file ") + m_path);
+	}
+	m_buf.clear();
+}
+
+void TraceWriter::close()
+{
+	if (!m_file) return;
+	try
+	{
+		flush();
+	}
+	catch (...)
+	{
+		std::fclose( m_file);
+		m_file = nullptr;
+		throw;
+	}
+	std::FILE* file = m_file;
+	m_file = nullptr;
+	if (0 != std::fclose( file)) throw std::runtime_error( std::string("failed to close trace file ") + m_path);
+}
+
+TraceReader::TraceReader( const std::string& path)
+	:m_path(path),m_file(std::fopen( path.c_str(), "rb")),m_fileSize(0),m_withValues(false)
+{
+	if (!m_file) throw std::runtime_error( std::string("failed to open trace file ") + path + ": " + std::strerror( errno));
+	long fileSize = (0 == std::fseek( m_file, 0, SEEK_END)) ? std::ftell( m_file) : -1;
+	if (fileSize < 0 || 0 != std::fseek( m_file, 0, SEEK_SET))
+	{
+		std::fclose( m_file);
+		throw std::runtime_error( std::string("failed to get the size of trace file ") + path);
+	}
+	m_fileSize = fileSize;
+	char magic[ 8];
+	unsigned char vf[ 2];
+	if (std::fread( magic, 1, sizeof(magic), m_file) != sizeof(magic) || 0 != std::memcmp( magic, TraceMagic, sizeof(magic))
+	||  std::fread( vf, 1, sizeof(vf), m_file) != sizeof(vf))
+	{
+		std::fclose( m_file);
+		throw std::runtime_error( std::string("not a trace file: ") + path);
+	}
+	if (vf[0] != TraceVersion)
+	{
+		std::fclose( m_file);
+		throw std::runtime_error( std::string("unsupported version of trace file ") + path);
+	}
+	m_withValues = (vf[1] & TraceFlagValues) != 0;
+}
+
+TraceReader::~TraceReader()
+{
+	std::fclose( m_file);
+}
+
+int TraceReader::readByte( bool eofAllowed)
+{
+	int ch = std::fgetc( m_file);
+	if (ch == EOF && !eofAllowed) throw std::runtime_error( std::string("unexpected end of trace file ") + m_path);
+	return ch;
+}
+
+std::uint64_t TraceReader::readVarint()
+{
+	std::uint64_t rt = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		int ch = readByte( false);
+		rt |= (std::uint64_t)(ch & 0x7f) << shift;
+		if (!(ch & 0x80)) return rt;
+	}
+	throw std::runtime_error( std::string("corrupt varint in trace file ") + m_path);
+}
+
+std::uint64_t TraceReader::readWord()
+{
+	std::uint64_t rt = 0;
+	for (int ii = 0; ii < 8; ++ii) rt |= (std::uint64_t)readByte( false) << (ii * 8);
+	return rt;
+}
+
+void TraceReader::readOperand( TraceOperand& opr)
+{
+	int kind = readByte( false);
+	opr.elements.clear();
+	opr.isInteger = (kind == 2);
+	opr.integer = 0;
+	opr.sign = (kind == 1);
+	opr.size = 0;
+	opr.hash = 0;
+	if (kind == 2)
+	{
+		std::uint64_t zz = readVarint();
+		opr.integer = (long)((zz >> 1) ^ (~(zz & 1) + 1));
+	}
+	else if (kind == 0 || kind == 1)
+	{
+		opr.size = readVarint();
+		if (m_withValues)
+		{
+			// ... the size is checked against the rest of the file before allocating for it
+			long pos = std::ftell( m_file);
+			if (pos < 0 || opr.size > (m_fileSize - pos) / sizeof(BigInt::Element))
+			{
+				throw std::runtime_error( std::string("corrupt number size in trace file ") + m_path);
+			}
+			opr.elements.reserve( opr.size);
+			for (std::size_t ii = 0; ii < opr.size; ++ii)
+			{
+				// ... the elements are used without validation by the operations, so they are checked here
+				std::uint64_t word = readWord();
+				if ((word >> 60) || checkvalue( word)) throw std::runtime_error( std::string("corrupt number in trace file ") + m_path);
+				opr.elements.push_back( word);
+			}
+			if (opr.size && !opr.elements.back()) throw std::runtime_error( std::string("corrupt number in trace file ") + m_path);
+			opr.hash = hash_elements( opr.elements.data(), opr.size);
+		}
+		else
+		{
+			opr.hash = readWord();
+		}
+	}
+	else
+	{
+		throw std::runtime_error( std::string("corrupt operand in trace file ") + m_path);
+	}
+}
+
+bool TraceReader::next( TraceRecord& rec)
+{
+	int op = readByte( true);
+	if (op == EOF) return false;
+	if (op >= NofTraceOps) throw std::runtime_error( std::string("unknown operation in trace file ") + m_path);
+	rec.op = (TraceOp)op;
+	rec.nofOperands = readByte( false);
+	if (rec.nofOperands > 2) throw std::runtime_error( std::string("corrupt record in trace file ") + m_path);
+	for (std::size_t oi = 0; oi < rec.nofOperands; ++oi) readOperand( rec.operands[ oi]);
+	return true;
+}
+
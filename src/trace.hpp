@@ -0,0 +1,139 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file trace.hpp
+///\brief Binary log of operations on BigInt numbers for replaying them offline
+#ifndef _BCD_TRACE_HPP_INCLUDED
+#define _BCD_TRACE_HPP_INCLUDED
+#include "bcd.hpp"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+namespace bcd {
+
+///\brief Operation codes of the trace records
+enum class TraceOp : unsigned char
+{
+	Parse,		///< number parsed from a string, operand is the result
+	ToString,	///< number converted to a string
+	Add,
+	Sub,
+	Mul,
+	Div,		///< division with remainder
+	Mod,
+	Pow,		///< power with an integer exponent
+	Neg,
+	Compare,
+	Root,		///< integer root with remainder, second operand is the degree
+	Save,		///< number saved to a file (bcd:save)
+	Write		///< number written to an open file (bcd:write)
+};
+enum {NofTraceOps = 13};
+
+///\brief Get the name of an operation code
+const char* traceOpName( TraceOp op) noexcept;
+
+///\struct TraceOperand
+///\brief Operand of a trace record, either a machine integer or a number
+struct TraceOperand
+{
+	bool isInteger;					///< true if the operand is a machine integer
+	long integer;					///< value of a machine integer operand
+	bool sign;					///< sign of a number operand
+	std::size_t size;				///< number of elements of a number operand
+	std::uint64_t hash;				///< hash of the elements of a number operand
+	std::vector<BigInt::Element> elements;		///< elements of a number operand, empty if only the size and the hash were recorded
+
+	TraceOperand()
+		:isInteger(false),integer(0),sign(false),size(0),hash(0){}
+
+	/// \brief Get the number of a number operand, a pseudo random number of the recorded size derived from the hash if the elements were not recorded
+	BigInt number() const;
+};
+
+///\struct TraceRecord
+///\brief Operation with its operands as read from a trace
+struct TraceRecord
+{
+	TraceOp op;
+	std::size_t nofOperands;
+	TraceOperand operands[ 2];
+};
+
+///\class TraceWriter
+///\brief Writer of a trace file, not thread safe
+class TraceWriter
+{
+public:
+	/// \brief Constructor, creates the file and writes the header
+	/// \param[in] path path of the file to create
+	/// \param[in] withValues true if the elements of the numbers are written, false if only their size and a hash
+	TraceWriter( const std::string& path, bool withValues);
+	/// \brief Destructor, closes the file if not done before, ignoring errors
+	~TraceWriter();
+
+	/// \brief Write a record of an operation with one or two operands
+	void write( TraceOp op, const BigInt& opr);
+	void write( TraceOp op, const BigInt& opr1, const BigInt& opr2);
+	void write( TraceOp op, const BigInt& opr1, long opr2);
+
+	/// \brief Flush the buffered records and close the file
+	void close();
+
+private:
+	TraceWriter( const TraceWriter&) = delete;
+	void operator=( const TraceWriter&) = delete;
+	void writeHeader( TraceOp op, std::size_t nofOperands);
+	void writeNumber( const BigInt& opr);
+	void writeInteger( long opr);
+	void flush();
+
+private:
+	std::string m_path;
+	std::FILE* m_file;
+	std::vector<unsigned char> m_buf;
+	bool m_withValues;
+};
+
+///\class TraceReader
+///\brief Reader of a trace file
+class TraceReader
+{
+public:
+	/// \brief Constructor, opens the file and checks the header
+	explicit TraceReader( const std::string& path);
+	/// \brief Destructor, closes the file
+	~TraceReader();
+
+	/// \brief Tell if the elements of the numbers were recorded
+	bool withValues() const noexcept	{return m_withValues;}
+	/// \brief Read the next record
+	/// \return false at the end of the file
+	bool next( TraceRecord& rec);
+
+private:
+	TraceReader( const TraceReader&) = delete;
+	void operator=( const TraceReader&) = delete;
+	int readByte( bool eofAllowed);
+	std::uint64_t readVarint();
+	std::uint64_t readWord();
+	void readOperand( TraceOperand& opr);
+
+private:
+	std::string m_path;
+	std::FILE* m_file;
+	std::size_t m_fileSize;
+	bool m_withValues;
+};
+
+}//namespace
+#endif
+
@@ -0,0 +1,292 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file benchBcd.cpp
+///\brief Microbenchmarks of the BigInt operations over operand sizes from 1 to 10^6 digits
+#include "bcd.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// ... result of an operation, kept to not let the compiler remove the evaluation
+static volatile std::size_t g_sink = 0;
+
+static void usage()
+{
+	std::cerr << "Usage: benchBcd [-h] [-o <output>] [-c <baseline>] [-t <tolerance>] [-m <maxdigits>] [-r <mintime>] [<operation>...]" << std::endl
+		<< "  -o <output>    write the results as JSON to the file <output> instead of stdout" << std::endl
+		<< "  -c <baseline>  compare the results with a JSON file written before and flag regressions" << std::endl
+		<< "  -t <tolerance> relative slowdown in percent flagged as regression in compare mode (default 10)" << std::endl
+		<< "  -m <maxdigits> maximum size of the operands in digits (default 1000000)" << std::endl
+		<< "  -r <mintime>   minimum running time of a measurement in milliseconds (default 100)" << std::endl
+		<< "  <operation>    operations to measure, all if not specified" << std::endl;
+}
+
+static std::string randomDigits( std::mt19937_64& rnd, std::size_t nofDigits)
+{
+	std::string rt;
+	rt.reserve( nofDigits);
+	rt.push_back( '1' + rnd() % 9);
+	while (rt.size() < nofDigits) rt.push_back( '0' + rnd() % 10);
+	return rt;
+}
+
+struct Operands
+{
+	std::string str;
+	bcd::BigInt arg1;
+	bcd::BigInt arg2;
+	bcd::BigInt half;
+	bcd::BigInt base;
+	std::vector<bcd::BigInt> bitvalues;
+};
+
+struct Benchmark
+{
+	const char* name;
+	std::size_t maxDigits;
+	std::function<void( const Operands& opr)> run;
+};
+
+struct Measurement
+{
+	std::string name;
+	std::size_t nofDigits;
+	std::size_t iterations;
+	double nsPerOp;
+	double digitsPerSec;
+};
+
+static const std::size_t PowExponent = 16;
+
+static std::vector<Benchmark> benchmarks()
+{
+	// ... the operations of quadratic complexity are limited to 10^4 digits, the bitwise operations that are very slow on BCD to 10^3 digits
+	return {
+		{"parse",	1000000,	[]( const Operands& opr){ g_sink += bcd::BigInt( opr.str).nof_digits();}},
+		{"tostring",	1000000,	[]( const Operands& opr){ g_sink += opr.arg1.tostring().size();}},
+		{"add",		1000000,	[]( const Operands& opr){ g_sink += (opr.arg1 + opr.arg2).nof_digits();}},
+		{"sub",		1000000,	[]( const Operands& opr){ g_sink += (opr.arg1 - opr.arg2).nof_digits();}},
+		{"mul_scalar",	1000000,	[]( const Operands& opr){ g_sink += (opr.arg1 * 987654321L).nof_digits();}},
+		{"mul",		10000,		[]( const Operands& opr){ g_sink += (opr.arg1 * opr.arg2).nof_digits();}},
+		{"div",		10000,		[]( const Operands& opr){ g_sink += opr.arg1.div( opr.half).first.nof_digits();}},
+		{"mod",		10000,		[]( const Operands& opr){ g_sink += opr.arg1.mod( opr.half).nof_digits();}},
+		{"pow",		10000,		[]( const Operands& opr){ g_sink += opr.base.pow( PowExponent).nof_digits();}},
+		{"compare",	1000000,	[]( const Operands& opr){ g_sink += opr.arg1.compare( opr.arg2) + 1;}},
+		{"bit_and",	1000,		[]( const Operands& opr){ g_sink += opr.arg1.bitwise_and( opr.arg2, opr.bitvalues).nof_digits();}},
+		{"bit_or",	1000,		[]( const Operands& opr){ g_sink += opr.arg1.bitwise_or( opr.arg2, opr.bitvalues).nof_digits();}},
+		{"bit_xor",	1000,		[]( const Operands& opr){ g_sink += opr.arg1.bitwise_xor( opr.arg2, opr.bitvalues).nof_digits();}}
+	};
+}
+
+static Operands createOperands( std::size_t nofDigits, bool withBitValues)
+{
+	std::mt19937_64 rnd( nofDigits);
+	Operands rt;
+	rt.str = randomDigits( rnd, nofDigits);
+	rt.arg1.init( rt.str);
+	// ... same leading digits for compare to scan the whole number
+	rt.arg2.init( rt.str.substr( 0, nofDigits / 2) + randomDigits( rnd, nofDigits - nofDigits / 2));
+	rt.half.init( randomDigits( rnd, (nofDigits + 1) / 2));
+	rt.base.init( randomDigits( rnd, (nofDigits + PowExponent - 1) / PowExponent));
+	// ... 3.33 bits per digit
+	if (withBitValues) rt.bitvalues = bcd::BigInt::getBitValues( (int)(nofDigits * 10 / 3 + 4));
+	return rt;
+}
+
+static Measurement measure( const Benchmark& bm, const Operands& opr, std::size_t nofDigits, double minTimeNs)
+{
+	typedef std::chrono::steady_clock Clock;
+	std::size_t iterations = 0;
+	std::size_t batch = 1;
+	double elapsed = 0.0;
+	while (elapsed < minTimeNs)
+	{
+		Clock::time_point start = Clock::now();
+		for (std::size_t ii = 0; ii < batch; ++ii) bm.run( opr);
+		elapsed += std::chrono::duration<double,std::nano>( Clock::now() - start).count();
+		iterations += batch;
+		if (elapsed < minTimeNs / 10) batch *= 2;
+	}
+	Measurement rt;
+	rt.name = bm.name;
+	rt.nofDigits = nofDigits;
+	rt.iterations = iterations;
+	rt.nsPerOp = elapsed / iterations;
+	rt.digitsPerSec = nofDigits * 1e9 / rt.nsPerOp;
+	return rt;
+}
+
+static std::string measurementKey( const std::string& name, std::size_t nofDigits)
+{
+	return name + "/" + std::to_string( nofDigits);
+}
+
+static std::string toJson( const std::vector<Measurement>& results)
+{
+	std::ostringstream out;
+	out << "{\n\t\"benchmarks\": [";
+	for (std::size_t ii = 0; ii < results.size(); ++ii)
+	{
+		char buf[ 512];
+		const Measurement& mt = results[ ii];
+		std::snprintf( buf, sizeof(buf), "%s\n\t\t{\"name\": \"%s\", \"digits\": %zu, \"iterations\": %zu, \"ns_per_op\": %.1f, \"digits_per_s\": %.1f}",
+				ii ? "," : "", mt.name.c_str(), mt.nofDigits, mt.iterations, mt.nsPerOp, mt.digitsPerSec);
+		out << buf;
+	}
+	out << "\n\t]\n}\n";
+	return out.str();
+}
+
+// ... reads only the format written by toJson, one measurement per line
+static std::map<std::string,double> readBaseline( const std::string& filename)
+{
+	std::ifstream inp( filename);
+	if (!inp) throw std::runtime_error( "failed to open baseline file " + filename);
+	std::map<std::string,double> rt;
+	std::string line;
+	while (std::getline( inp, line))
+	{
+		char name[ 128];
+		std::size_t nofDigits;
+		double nsPerOp;
+		const char* start = std::strchr( line.c_str(), '{');
+		if (start && 3 == std::sscanf( start, "{\"name\": \"%127[^\"]\", \"digits\": %zu, \"iterations\": %*u, \"ns_per_op\": %lf", name, &nofDigits, &nsPerOp))
+		{
+			rt[ measurementKey( name, nofDigits)] = nsPerOp;
+		}
+	}
+	if (rt.empty()) throw std::runtime_error( "no measurements found in baseline file " + filename);
+	return rt;
+}
+
+static int compareBaseline( const std::vector<Measurement>& results, const std::map<std::string,double>& baseline, double tolerance)
+{
+	int nofRegressions = 0;
+	for (const Measurement& mt : results)
+	{
+		auto bi = baseline.find( measurementKey( mt.name, mt.nofDigits));
+		if (bi == baseline.end()) continue;
+		double ratio = mt.nsPerOp / bi->second;
+		bool regression = ratio > 1.0 + tolerance / 100;
+		if (regression) ++nofRegressions;
+		std::fprintf( stderr, "%-12s %8zu digits %14.1f ns/op baseline %14.1f ns/op %+7.1f%%%s\n",
+				mt.name.c_str(), mt.nofDigits, mt.nsPerOp, bi->second, (ratio - 1.0) * 100, regression ? " REGRESSION" : "");
+	}
+	std::fprintf( stderr, "%d regressions\n", nofRegressions);
+	return nofRegressions;
+}
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		std::string outputFile;
+		std::string baselineFile;
+		double tolerance = 10.0;
+		std::size_t maxDigits = 1000000;
+		double minTimeNs = 100e6;
+		std::vector<std::string> selected;
+
+		int argi = 1;
+		for (; argi < argc; ++argi)
+		{
+			std::string opt = argv[ argi];
+			if (opt == "-h")
+			{
+				usage();
+				return 0;
+			}
+			else if (opt.size() == 2 && opt[0] == '-' && std::strchr( "octmr", opt[1]))
+			{
+				if (argi+1 == argc) throw std::runtime_error( "missing argument of option " + opt);
+				const char* arg = argv[ ++argi];
+				switch (opt[1])
+				{
+					case 'o': outputFile = arg; break;
+					case 'c': baselineFile = arg; break;
+					case 't': tolerance = std::atof( arg); break;
+					case 'm': maxDigits = std::strtoul( arg, nullptr, 10); break;
+					case 'r': minTimeNs = std::atof( arg) * 1e6; break;
+				}
+			}
+			else if (opt[0] == '-')
+			{
+				usage();
+				throw std::runtime_error( "unknown option " + opt);
+			}
+			else
+			{
+				selected.push_back( opt);
+			}
+		}
+		std::vector<Benchmark> all = benchmarks();
+		std::vector<Benchmark> todo;
+		for (const Benchmark& bm : all)
+		{
+			bool isSelected = selected.empty();
+			for (const std::string& name : selected) isSelected |= (name == bm.name);
+			if (isSelected) todo.push_back( bm);
+		}
+		if (todo.empty()) throw std::runtime_error( "no benchmark selected");
+		// ... read before the measurements, the baseline may be overwritten by the output
+		std::map<std::string,double> baseline;
+		if (!baselineFile.empty()) baseline = readBaseline( baselineFile);
+
+		std::vector<Measurement> results;
+		for (std::size_t nofDigits = 1; nofDigits <= maxDigits; nofDigits *= 10)
+		{
+			Operands opr;
+			bool hasOperands = false;
+			for (const Benchmark& bm : todo)
+			{
+				if (nofDigits > bm.maxDigits) continue;
+				if (!hasOperands)
+				{
+					opr = createOperands( nofDigits, nofDigits <= 1000);
+					hasOperands = true;
+				}
+				results.push_back( measure( bm, opr, nofDigits, minTimeNs));
+				const Measurement& mt = results.back();
+				std::fprintf( stderr, "%-12s %8zu digits %14.1f ns/op %16.1f digits/s\n", mt.name.c_str(), mt.nofDigits, mt.nsPerOp, mt.digitsPerSec);
+			}
+		}
+		std::string json = toJson( results);
+		if (outputFile.empty())
+		{
+			std::cout << json;
+		}
+		else
+		{
+			std::ofstream out( outputFile);
+			out << json;
+			if (!out) throw std::runtime_error( "failed to write output file " + outputFile);
+		}
+		if (!baselineFile.empty())
+		{
+			return compareBaseline( results, baseline, tolerance) ? 1 : 0;
+		}
+		return 0;
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << "ERROR " << err.what() << std::endl;
+		return 2;
+	}
+}
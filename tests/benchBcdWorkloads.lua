@@ -0,0 +1,168 @@
+bcd = require "bcd"
+lapp = require( 'pl.lapp')
+
+local args = lapp( [[
+Workload benchmarks for Lua bcd module, measuring the arithmetics including the Lua binding
+	-h,--help                 Print usage
+	-s,--scale  (default 1)   Factor for the number of operations of each workload
+	-w,--workload (default "") Run only the workload with this name
+]])
+if args.help then
+	print( "Usage: benchBcdWorkloads.lua [-h][-s <scale>][-w <workload>]")
+	os.exit( 0)
+end
+local scale = tonumber( args.scale) or 1
+
+-- Deterministic pseudo random numbers, same sequence for every run
+local seed = 1
+local function random( range)
+	seed = (seed * 1103515245 + 12345) % 2147483648
+	return seed % range
+end
+
+local function randomDigits( nofDigits)
+	local digits = { tostring( 1 + random( 9)) }
+	for ii = 2, nofDigits do digits[ ii] = tostring( random( 10)) end
+	return table.concat( digits)
+end
+
+-- Peaks of the memory used by Lua and of the memory allocated for numbers outside of the userdata
+local peakLua = 0
+local peakBcd = 0
+local function sample()
+	local kb = collectgarbage( "count")
+	if kb > peakLua then peakLua = kb end
+	local bytes = bcd.memory()
+	if bytes > peakBcd then peakBcd = bytes end
+end
+
+local function checkResult( name, output, expected)
+	if tostring(output) ~= tostring(expected) then
+		io.stderr:write( "OUTPUT: " .. tostring(output) .. "\n")
+		io.stderr:write( "EXPECT: " .. tostring(expected) .. "\n")
+		error( "Workload " .. name .. " failed")
+	end
+end
+
+local workloads = {}
+
+-- Sum of amounts in cents given as strings, as in a ledger
+table.insert( workloads, { name = "ledger", run = function( nn)
+	local entries = {}
+	for ii = 1, nn do entries[ ii] = (random( 4) == 0 and "-" or "") .. randomDigits( 1 + random( 12)) end
+	local total = bcd.int( 0)
+	for ii = 1, nn do
+		total = total + entries[ ii]
+		sample()
+	end
+	return nn
+end})
+
+-- Compound interest of 3.75 percent per period with 20 digits of precision
+table.insert( workloads, { name = "interest", run = function( nn)
+	local capital = bcd.int( "100000000000000000000000")
+	for ii = 1, nn do
+		capital = capital * 10375 / 10000
+		sample()
+	end
+	return 2 * nn
+end})
+
+-- Factorial as product of a sequence of machine integers
+table.insert( workloads, { name = "factorial", run = function( nn)
+	local result = bcd.int( 1)
+	for ii = 2, nn do
+		result = result * ii
+		sample()
+	end
+	checkResult( "factorial", result, bcd.factorial( nn))
+	return nn - 1
+end})
+
+-- Fibonacci sequence
+table.insert( workloads, { name = "fibonacci", run = function( nn)
+	local f1, f2 = bcd.int( 0), bcd.int( 1)
+	for ii = 1, nn do
+		f1, f2 = f2, f1 + f2
+		sample()
+	end
+	return nn
+end})
+
+-- Digits of pi with Machin's formula pi = 16 arctan(1/5) - 4 arctan(1/239)
+local function arctanInverse( unity, xx)
+	local ops = 1
+	local term = unity / xx
+	local sum = term
+	local kk = 1
+	local x2 = xx * xx
+	local zero = bcd.int( 0)
+	while term ~= zero do
+		term = term / x2
+		local part = term / (2 * kk + 1)
+		if kk % 2 == 1 then sum = sum - part else sum = sum + part end
+		kk = kk + 1
+		ops = ops + 3
+		sample()
+	end
+	return sum, ops
+end
+
+table.insert( workloads, { name = "pi", run = function( nn)
+	local unity = bcd.int( 10) ^ (nn + 10)
+	local a1, ops1 = arctanInverse( unity, 5)
+	local a2, ops2 = arctanInverse( unity, 239)
+	local pi = (a1 * 16 - a2 * 4) / bcd.int( 10) ^ 10
+	checkResult( "pi", string.sub( tostring( pi), 1, 20), "31415926535897932384")
+	return ops1 + ops2 + 4
+end})
+
+-- Check digits modulo 97 of account numbers given as strings
+table.insert( workloads, { name = "checksum", run = function( nn)
+	local accounts = {}
+	for ii = 1, nn do accounts[ ii] = randomDigits( 30) end
+	local nofValid = 0
+	for ii = 1, nn do
+		local checksum = bcd.int( accounts[ ii]) % 97
+		if checksum == bcd.int( 1) then nofValid = nofValid + 1 end
+		sample()
+	end
+	return 3 * nn
+end})
+
+-- Sorting with the comparison metamethods
+table.insert( workloads, { name = "sorting", run = function( nn)
+	local values = {}
+	for ii = 1, nn do values[ ii] = bcd.int( (random( 2) == 0 and "-" or "") .. randomDigits( 1 + random( 40))) end
+	local nofCompares = 0
+	table.sort( values, function( a, b) nofCompares = nofCompares + 1; return a < b end)
+	sample()
+	for ii = 2, nn do
+		if values[ ii] < values[ ii-1] then error( "Workload sorting failed") end
+	end
+	return nofCompares
+end})
+
+local sizes = {
+	["ledger"] = 20000,
+	["interest"] = 2000,
+	["factorial"] = 2000,
+	["fibonacci"] = 20000,
+	["pi"] = 1000,
+	["checksum"] = 20000,
+	["sorting"] = 10000
+}
+
+print( string.format( "%-20s %10s %14s %16s %16s", "workload", "ops", "ops/s", "peak Lua KB", "peak bcd KB"))
+for _,workload in ipairs( workloads) do
+	if args.workload == "" or args.workload == workload.name then
+		collectgarbage( "collect")
+		peakLua = 0
+		peakBcd = 0
+		sample()
+		local start = os.clock()
+		local ops = workload.run( math.floor( sizes[ workload.name] * scale))
+		local elapsed = os.clock() - start
+		print( string.format( "%-20s %10d %14.0f %16.0f %16.0f", workload.name, ops, ops / elapsed, peakLua, peakBcd / 1024))
+	end
+end
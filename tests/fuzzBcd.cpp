@@ -0,0 +1,486 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file fuzzBcd.cpp
+///\brief Differential test of the BigInt operations against the reference algorithms (BigInt::setReferenceMode) or against a model computing the result differently
+///\note Built as libFuzzer target if BCD_LIBFUZZER is defined, as standalone program with random operands otherwise
+#include "bcd.hpp"
+#include "expression.hpp"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+
+// ... source of the bytes the operands are derived from
+class OperandSource
+{
+public:
+	virtual ~OperandSource(){}
+	virtual unsigned char byte() = 0;
+
+	std::uint64_t value( unsigned int nofBytes)
+	{
+		std::uint64_t rt = 0;
+		for (unsigned int ii = 0; ii < nofBytes; ++ii) rt = (rt << 8) | byte();
+		return rt;
+	}
+};
+
+class RandomSource
+	:public OperandSource
+{
+public:
+	explicit RandomSource( std::uint64_t seed) :m_rnd(seed){}
+	virtual unsigned char byte()		{return (unsigned char)m_rnd();}
+
+private:
+	std::mt19937_64 m_rnd;
+};
+
+class DataSource
+	:public OperandSource
+{
+public:
+	DataSource( const std::uint8_t* data, std::size_t size) :m_data(data),m_size(size),m_pos(0){}
+	virtual unsigned char byte()		{return m_pos < m_size ? m_data[ m_pos++] : 0;}
+
+private:
+	const std::uint8_t* m_data;
+	std::size_t m_size;
+	std::size_t m_pos;
+};
+
+// ... sizes skewed to small numbers and to the element boundaries of 15 digits, digit patterns provoking long carry chains
+static bcd::BigInt createNumber( OperandSource& src, std::size_t maxDigits)
+{
+	unsigned char kind = src.byte();
+	std::size_t nofDigits;
+	switch (kind & 3)
+	{
+		case 0: nofDigits = src.byte() % 16; break;
+		case 1: nofDigits = 15 * (1 + src.byte() % 8) + (src.byte() % 3) - 1; break;
+		default:
+		{
+			unsigned int bits = src.byte() % 24;
+			nofDigits = src.value( 3) & ((1U << bits) - 1);
+		}
+	}
+	if (nofDigits > maxDigits) nofDigits = maxDigits;
+	std::string str;
+	if (kind & 4) str.push_back( '-');
+	for (std::size_t ii = 0; ii < nofDigits; ++ii)
+	{
+		switch ((kind >> 3) & 3)
+		{
+			case 0: str.push_back( '0' + src.byte() % 10); break;
+			case 1: str.push_back( '9'); break;
+			case 2: str.push_back( ii ? '0' : '1'); break;
+			default: str.push_back( (src.byte() & 1) ? '9' : '0'); break;
+		}
+	}
+	if (nofDigits == 0) str.push_back( '0');
+	return bcd::BigInt( str);
+}
+
+static long createLong( OperandSource& src)
+{
+	switch (src.byte() % 6)
+	{
+		case 0: return (long)(signed char)src.byte();
+		case 1: return std::numeric_limits<long>::max() - src.byte();
+		case 2: return std::numeric_limits<long>::min() + src.byte();
+		case 3: return (long)(999999999999999ULL + src.byte() % 3) * ((src.byte() & 1) ? -1 : 1);
+		default: return (long)src.value( 8);
+	}
+}
+
+struct Operands
+{
+	bcd::BigInt arg1;
+	bcd::BigInt arg2;
+	long num;
+};
+
+struct Check
+{
+	const char* name;
+	std::function<std::string( const Operands& opr)> run;
+	// ... independent computation of the expected result, the run in the reference mode if not defined
+	std::function<std::string( const Operands& opr)> model;
+};
+
+static std::string divisionResult( const std::pair<bcd::BigInt,bcd::BigInt>& res)
+{
+	return res.first.tostring() + " rem " + res.second.tostring();
+}
+
+// ... the number with only the lowest maxDigits digits kept, keeping the sign
+static bcd::BigInt lowestDigits( const bcd::BigInt& num, std::size_t maxDigits)
+{
+	std::string str = num.tostring();
+	std::size_t start = (str[0] == '-') ? 1 : 0;
+	if (str.size() - start > maxDigits) str.erase( start, str.size() - start - maxDigits);
+	if (str.size() == start) return bcd::BigInt();
+	return bcd::BigInt( str);
+}
+
+// ... operations of the fixed size numbers, evaluated with BigInt as model
+enum {FixedNumberDigits = 30};
+typedef bcd::FixedBigInt<4> FixedNumber;
+
+template <class Number>
+static std::string fixedOperations( const Number& aa, const Number& bb, long num)
+{
+	std::string rt = aa.add( bb).tostring() + " " + aa.sub( bb).tostring() + " " + aa.neg().tostring()
+			+ " " + aa.mul( bb).tostring() + " " + aa.mul( num).tostring() + " " + std::to_string( aa.compare( bb));
+	if (!bb.isNull())
+	{
+		auto res = aa.div( bb);
+		rt += " " + res.first.tostring() + " rem " + res.second.tostring() + " " + aa.mod( bb).tostring();
+	}
+	return rt;
+}
+
+static std::string fixedCheck( const Operands& opr)
+{
+	FixedNumber aa( lowestDigits( opr.arg1, FixedNumberDigits));
+	FixedNumber bb( lowestDigits( opr.arg2, FixedNumberDigits));
+	return fixedOperations( aa, bb, opr.num % 1000000000L);
+}
+
+static std::string fixedModel( const Operands& opr)
+{
+	bcd::BigInt aa = lowestDigits( opr.arg1, FixedNumberDigits);
+	bcd::BigInt bb = lowestDigits( opr.arg2, FixedNumberDigits);
+	return fixedOperations( aa, bb, opr.num % 1000000000L);
+}
+
+// ... the root computed with the reference algorithms, accepted only if it is the floor of the root
+static std::string rootModel( const bcd::BigInt& num, unsigned int nn)
+{
+	std::pair<bcd::BigInt,bcd::BigInt> res = num.iroot( nn);
+	if (res.first.pow( nn).add( res.second).compare( num) != 0 || res.second.sign() == '-'
+	||  res.first.add( 1L).pow( nn).compare( num) <= 0)
+	{
+		return "not the floor root " + divisionResult( res);
+	}
+	return divisionResult( res);
+}
+
+static unsigned int rootDegree( const Operands& opr)
+{
+	return 3 + (unsigned long)opr.num % 6;
+}
+
+// ... operands of pow limited in size, the result grows with the exponent
+enum {PowBaseDigits = 100};
+
+static unsigned long powExponent( const Operands& opr)
+{
+	return (unsigned long)opr.num % 8;
+}
+
+static std::string powModel( const Operands& opr)
+{
+	bcd::BigInt base = lowestDigits( opr.arg1, PowBaseDigits);
+	bcd::BigInt rt( 1L);
+	for (unsigned long ii = 0, nn = powExponent( opr); ii < nn; ++ii) rt = rt.mul( base);
+	return rt.tostring();
+}
+
+static int shiftDigits( const Operands& opr)
+{
+	return (int)(opr.num % 64);
+}
+
+// ... the shift as appending or removing decimal digits, the removed digits are truncated towards zero
+static std::string shiftModel( const Operands& opr)
+{
+	int digits = shiftDigits( opr);
+	std::string str = opr.arg1.tostring();
+	if (str == "0") return str;
+	if (digits >= 0) return str + std::string( digits, '0');
+	std::size_t start = (str[0] == '-') ? 1 : 0;
+	if (str.size() - start <= (std::size_t)-digits) return "0";
+	return str.substr( 0, str.size() + digits);
+}
+
+static unsigned int cutDigits( const Operands& opr)
+{
+	return (unsigned long)opr.num % 1000;
+}
+
+enum {MaxFactorialArgument = 500};
+
+static std::string factorialModel( const Operands& opr)
+{
+	bcd::BigInt rt( 1L);
+	for (long ii = 2, nn = (unsigned long)opr.num % MaxFactorialArgument; ii <= nn; ++ii) rt = rt.mul( ii);
+	return rt.tostring();
+}
+
+// ... small kk for large nn (factors of the window with the denominator divided out) or any kk for small nn (prime sieve)
+static std::pair<unsigned long,unsigned long> binomialArguments( const Operands& opr)
+{
+	unsigned long nn = (opr.num & 1) ? (unsigned long)opr.num % 2000000 : (unsigned long)opr.num % 300;
+	unsigned long kk = ((unsigned long)opr.num >> 32) % (nn < 300 ? nn + 2 : 40);
+	return {nn, kk};
+}
+
+static std::string binomialModel( const Operands& opr)
+{
+	std::pair<unsigned long,unsigned long> arg = binomialArguments( opr);
+	if (arg.second > arg.first) return "0 rem 0";
+	bcd::BigInt numerator( 1L), denominator( 1L);
+	for (unsigned long ii = 0; ii < arg.second; ++ii)
+	{
+		numerator = numerator.mul( (long)(arg.first - ii));
+		denominator = denominator.mul( (long)(ii + 1));
+	}
+	return divisionResult( numerator.div( denominator));
+}
+
+static std::string packCheck( const Operands& opr)
+{
+	std::string packed = opr.arg1.serialize();
+	// ... a buffer not aligned to the elements is loaded word by word
+	std::string unaligned = " " + packed;
+	return bcd::BigInt::deserialize( packed.data(), packed.size()).tostring()
+		+ " " + bcd::BigInt::deserialize( unaligned.data() + 1, packed.size()).tostring();
+}
+
+static std::string dotModel( const Operands& opr)
+{
+	bcd::BigInt cc( opr.num);
+	return opr.arg1.mul( opr.arg2).add( opr.arg2.mul( opr.arg1)).add( opr.arg1.mul( cc)).tostring();
+}
+
+// ... expression ((-(a-c)) + ((a+b)*(a-c) mod b)) - (a+b) div c with c the long operand as constant
+static std::string expressionCheck( const Operands& opr)
+{
+	typedef bcd::ExpressionOp Op;
+	bcd::ExpressionGraph graph( 2);
+	bcd::ExpressionGraph::NodeIndex cc = graph.constant( bcd::BigInt( opr.num));
+	bcd::ExpressionGraph::NodeIndex sum = graph.operation( Op::Add, 0, 1);
+	bcd::ExpressionGraph::NodeIndex diff = graph.operation( Op::Sub, 0, cc);
+	bcd::ExpressionGraph::NodeIndex mod = graph.operation( Op::Mod, graph.operation( Op::Mul, sum, diff), 1);
+	bcd::ExpressionGraph::NodeIndex left = graph.operation( Op::Add, graph.operation( Op::Neg, diff, diff), mod);
+	bcd::ExpressionGraph::NodeIndex root = graph.operation( Op::Sub, left, graph.operation( Op::Div, sum, cc));
+	bcd::CompiledExpression expr( graph, root);
+	const bcd::BigInt* args[ 2] = {&opr.arg1, &opr.arg2};
+	return expr.evaluate( args).tostring();
+}
+
+static std::string expressionModel( const Operands& opr)
+{
+	bcd::BigInt cc( opr.num);
+	bcd::BigInt sum = opr.arg1.add( opr.arg2);
+	bcd::BigInt diff = opr.arg1.sub( cc);
+	bcd::BigInt mod = sum.mul( diff).mod( opr.arg2);
+	return diff.neg().add( mod).sub( sum.div( cc).first).tostring();
+}
+
+static std::vector<Check> checks()
+{
+	return {
+		{"add",		[]( const Operands& opr){ return opr.arg1.add( opr.arg2).tostring();}},
+		{"sub",		[]( const Operands& opr){ return opr.arg1.sub( opr.arg2).tostring();}},
+		{"mul",		[]( const Operands& opr){ return opr.arg1.mul( opr.arg2).tostring();}},
+		{"div",		[]( const Operands& opr){ return divisionResult( opr.arg1.div( opr.arg2));}},
+		{"mod",		[]( const Operands& opr){ return opr.arg1.mod( opr.arg2).tostring();}},
+		{"compare",	[]( const Operands& opr){ return std::to_string( opr.arg1.compare( opr.arg2));}},
+		{"add_long",	[]( const Operands& opr){ return opr.arg1.add( opr.num).tostring();}},
+		{"sub_long",	[]( const Operands& opr){ return opr.arg1.sub( opr.num).tostring();}},
+		{"mul_long",	[]( const Operands& opr){ return opr.arg1.mul( opr.num).tostring();}},
+		{"div_long",	[]( const Operands& opr){ return divisionResult( opr.arg1.div( opr.num));}},
+		{"mod_long",	[]( const Operands& opr){ return opr.arg1.mod( opr.num).tostring();}},
+		{"compare_long",[]( const Operands& opr){ return std::to_string( opr.arg1.compare( opr.num));}},
+		{"product",	[]( const Operands& opr){ return bcd::BigInt::product( {opr.arg1, opr.arg2, opr.arg1}).tostring();}},
+		{"sum",		[]( const Operands& opr){ return bcd::BigInt::sum( {&opr.arg1, &opr.arg2, &opr.arg1}).tostring();}},
+		{"fixed",	fixedCheck, fixedModel},
+		{"isqrt",	[]( const Operands& opr){ return divisionResult( opr.arg1.isqrt());},
+				[]( const Operands& opr){ return rootModel( opr.arg1, 2);}},
+		{"iroot",	[]( const Operands& opr){ return divisionResult( opr.arg1.iroot( rootDegree( opr)));},
+				[]( const Operands& opr){ return rootModel( opr.arg1, rootDegree( opr));}},
+		{"pow",		[]( const Operands& opr){ return lowestDigits( opr.arg1, PowBaseDigits).pow( powExponent( opr)).tostring();}, powModel},
+		{"shift",	[]( const Operands& opr){ return opr.arg1.shift( shiftDigits( opr)).tostring();}, shiftModel},
+		{"cut",		[]( const Operands& opr){ return opr.arg1.cut( cutDigits( opr)).tostring();},
+				[]( const Operands& opr){ return lowestDigits( opr.arg1, cutDigits( opr)).tostring();}},
+		{"round",	[]( const Operands& opr){ return opr.arg1.round( opr.arg2).tostring();}},
+		{"factorial",	[]( const Operands& opr){ return bcd::BigInt::factorial( (unsigned long)opr.num % MaxFactorialArgument).tostring();}, factorialModel},
+		{"binomial",	[]( const Operands& opr){ std::pair<unsigned long,unsigned long> arg = binomialArguments( opr); return bcd::BigInt::binomial( arg.first, arg.second).tostring() + " rem 0";}, binomialModel},
+		{"pack",	packCheck, []( const Operands& opr){ return opr.arg1.tostring() + " " + opr.arg1.tostring();}},
+		{"dot",		[]( const Operands& opr){ bcd::BigInt cc( opr.num); return bcd::BigInt::dot( {&opr.arg1, &opr.arg2, &opr.arg1}, {&opr.arg2, &opr.arg1, &cc}).tostring();}, dotModel},
+		{"sum_negate",	[]( const Operands& opr){ return bcd::BigInt::sum( {&opr.arg1, &opr.arg2, &opr.arg1}, {false, true, true}).tostring();},
+				[]( const Operands& opr){ return opr.arg2.neg().tostring();}},
+		{"expression",	expressionCheck, expressionModel}
+	};
+}
+
+// ... result of an operation or the error it threw, failing operations must fail in the reference mode too
+static std::string evaluate( const Check& check, const Operands& opr, bool referenceMode, double& ns)
+{
+	typedef std::chrono::steady_clock Clock;
+	bcd::BigInt::setReferenceMode( referenceMode);
+	Clock::time_point start = Clock::now();
+	std::string rt;
+	try
+	{
+		rt = (referenceMode && check.model) ? check.model( opr) : check.run( opr);
+	}
+	catch (const std::runtime_error& err)
+	{
+		rt = std::string("error ") + err.what();
+	}
+	ns += std::chrono::duration<double,std::nano>( Clock::now() - start).count();
+	bcd::BigInt::setReferenceMode( false);
+	return rt;
+}
+
+struct CheckTotals
+{
+	std::size_t count;
+	double ns;
+	double referenceNs;
+};
+
+// ... returns false and reports the operands if the results of the fast paths and the reference algorithms differ
+static bool runChecks( OperandSource& src, std::size_t maxDigits, std::vector<CheckTotals>& totals)
+{
+	static const std::vector<Check> all = checks();
+	Operands opr;
+	opr.arg1 = createNumber( src, maxDigits);
+	opr.arg2 = createNumber( src, maxDigits);
+	opr.num = createLong( src);
+	for (std::size_t ci = 0; ci < all.size(); ++ci)
+	{
+		std::string result, expected;
+		try
+		{
+			result = evaluate( all[ ci], opr, false, totals[ ci].ns);
+			expected = evaluate( all[ ci], opr, true, totals[ ci].referenceNs);
+		}
+		catch (const std::exception& err)
+		{
+			// ... other errors than std::runtime_error are bugs in any mode
+			bcd::BigInt::setReferenceMode( false);
+			expected = "no internal error";
+			result = std::string("internal error ") + err.what();
+		}
+		++totals[ ci].count;
+		if (result != expected)
+		{
+			std::cerr << "MISMATCH in " << all[ ci].name << std::endl
+				<< "ARG1:   " << opr.arg1.tostring() << std::endl
+				<< "ARG2:   " << opr.arg2.tostring() << std::endl
+				<< "LONG:   " << opr.num << std::endl
+				<< "RESULT: " << result << std::endl
+				<< "EXPECT: " << expected << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// ... above the parallelization threshold set with -t, small enough for runs under the sanitizers
+enum {DefaultMaxDigits = 400};
+
+#ifdef BCD_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput( const std::uint8_t* data, std::size_t size)
+{
+	static std::vector<CheckTotals> totals( checks().size(), CheckTotals{0,0.0,0.0});
+	DataSource src( data, size);
+	if (!runChecks( src, DefaultMaxDigits, totals)) std::abort();
+	return 0;
+}
+#else
+static void usage()
+{
+	std::cerr << "Usage: fuzzBcd [-h] [-n <iterations>] [-s <seed>] [-m <maxdigits>] [-t <threads>]" << std::endl
+		<< "  -n <iterations> number of operand sets checked (default 10000)" << std::endl
+		<< "  -s <seed>       seed of the pseudo random operands (default 1)" << std::endl
+		<< "  -m <maxdigits>  maximum size of the operands in digits (default " << DefaultMaxDigits << ")" << std::endl
+		<< "  -t <threads>    number of threads, with a low parallelization threshold if more than 1 (default 1)" << std::endl;
+}
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		std::size_t iterations = 10000;
+		std::uint64_t seed = 1;
+		std::size_t maxDigits = DefaultMaxDigits;
+		unsigned int nofThreads = 1;
+
+		for (int argi = 1; argi < argc; ++argi)
+		{
+			std::string opt = argv[ argi];
+			if (opt == "-h")
+			{
+				usage();
+				return 0;
+			}
+			else if (opt.size() == 2 && opt[0] == '-' && (opt[1] == 'n' || opt[1] == 's' || opt[1] == 'm' || opt[1] == 't'))
+			{
+				if (argi+1 == argc) throw std::runtime_error( "missing argument of option " + opt);
+				unsigned long arg = std::strtoul( argv[ ++argi], nullptr, 10);
+				switch (opt[1])
+				{
+					case 'n': iterations = arg; break;
+					case 's': seed = arg; break;
+					case 'm': maxDigits = arg; break;
+					case 't': nofThreads = arg; break;
+				}
+			}
+			else
+			{
+				usage();
+				throw std::runtime_error( "unknown argument " + opt);
+			}
+		}
+		if (nofThreads > 1)
+		{
+			bcd::BigInt::setNofThreads( nofThreads);
+			bcd::BigInt::setParallelThreshold( 100);
+		}
+		std::vector<Check> all = checks();
+		std::vector<CheckTotals> totals( all.size(), CheckTotals{0,0.0,0.0});
+		RandomSource src( seed);
+		for (std::size_t ii = 0; ii < iterations; ++ii)
+		{
+			if (!runChecks( src, maxDigits, totals))
+			{
+				std::cerr << "FAILED after " << ii << " iterations with seed " << seed << std::endl;
+				return 1;
+			}
+		}
+		std::printf( "%-14s %10s %14s %14s %10s\n", "operation", "checks", "ns/op", "reference", "speedup");
+		for (std::size_t ci = 0; ci < all.size(); ++ci)
+		{
+			const CheckTotals& tt = totals[ ci];
+			std::printf( "%-14s %10zu %14.1f %14.1f %9.2fx\n", all[ ci].name, tt.count, tt.ns / tt.count, tt.referenceNs / tt.count, tt.referenceNs / tt.ns);
+		}
+		std::printf( "OK %zu iterations\n", iterations);
+		return 0;
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << "ERROR " << err.what() << std::endl;
+		return 2;
+	}
+}
+#endif
+
@@ -0,0 +1,7 @@
+#!/bin/sh
+
+LUABIN=$1
+shift
+
+. tests/luaenv.sh
+$LUABIN tests/benchBcdWorkloads.lua "$@"
@@ -1,8 +1,11 @@
 #!/bin/sh
 
 LUABIN=$1
+REPLAY=$2
+TRACEFILE=build/testBcdArithmetics.trace
 
 . tests/luaenv.sh
-$LUABIN tests/testBcdArithmetics.lua -V
-
-
+$LUABIN tests/testBcdArithmetics.lua -V -T $TRACEFILE || exit 1
+# ... the operations traced by the test must replay without failures
+$REPLAY -f $TRACEFILE || exit 1
+rm $TRACEFILE
@@ -0,0 +1,206 @@
+/*
+  Copyright (c) 2020 Patrick P. Frey
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+///\file replayBcd.cpp
+///\brief Replays the operations of a trace written with bcd.trace_start and reports the throughput
+#include "bcd.hpp"
+#include "trace.hpp"
+#include "numberfile.hpp"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+// ... result of an operation, kept to not let the compiler remove the evaluation
+static volatile std::size_t g_sink = 0;
+// ... numbers saved or written are discarded
+#define NullDevice "/dev/null"
+static std::FILE* g_nullFile = nullptr;
+
+static void usage()
+{
+	std::cerr << "Usage: replayBcd [-h] [-r <repeat>] [-f] <tracefile>" << std::endl
+		<< "  -r <repeat>    number of times the trace is replayed (default 1)" << std::endl
+		<< "  -f             exit with an error if an operation failed in the replay" << std::endl
+		<< "  <tracefile>    file written with bcd.trace_start" << std::endl;
+}
+
+// ... operation with its operands converted before the measurement
+struct Operation
+{
+	bcd::TraceOp op;
+	bcd::BigInt arg1;
+	bcd::BigInt arg2;
+	long integer;
+	bool isInteger;
+	std::string str;
+};
+
+static Operation createOperation( const bcd::TraceRecord& rec)
+{
+	Operation rt;
+	rt.op = rec.op;
+	rt.integer = 0;
+	rt.isInteger = false;
+	if (rec.nofOperands < 1 || rec.operands[0].isInteger) throw std::runtime_error( "bad first operand in trace record");
+	rt.arg1 = rec.operands[0].number();
+	if (rec.nofOperands > 1)
+	{
+		if (rec.operands[1].isInteger)
+		{
+			rt.isInteger = true;
+			rt.integer = rec.operands[1].integer;
+		}
+		else
+		{
+			rt.arg2 = rec.operands[1].number();
+		}
+	}
+	if (rt.op == bcd::TraceOp::Parse) rt.str = rt.arg1.tostring();
+	return rt;
+}
+
+static void execute( const Operation& opr)
+{
+	switch (opr.op)
+	{
+		case bcd::TraceOp::Parse: g_sink += bcd::BigInt( opr.str).nof_digits(); break;
+		case bcd::TraceOp::ToString: g_sink += opr.arg1.tostring().size(); break;
+		case bcd::TraceOp::Add: g_sink += (opr.isInteger ? opr.arg1.add( opr.integer) : opr.arg1.add( opr.arg2)).nof_digits(); break;
+		case bcd::TraceOp::Sub: g_sink += (opr.isInteger ? opr.arg1.sub( opr.integer) : opr.arg1.sub( opr.arg2)).nof_digits(); break;
+		case bcd::TraceOp::Mul: g_sink += (opr.isInteger ? opr.arg1.mul( opr.integer) : opr.arg1.mul( opr.arg2)).nof_digits(); break;
+		case bcd::TraceOp::Div: g_sink += (opr.isInteger ? opr.arg1.div( opr.integer) : opr.arg1.div( opr.arg2)).first.nof_digits(); break;
+		case bcd::TraceOp::Mod: g_sink += (opr.isInteger ? opr.arg1.mod( opr.integer) : opr.arg1.mod( opr.arg2)).nof_digits(); break;
+		case bcd::TraceOp::Pow: g_sink += opr.arg1.pow( opr.integer).nof_digits(); break;
+		case bcd::TraceOp::Neg: g_sink += opr.arg1.neg().nof_digits(); break;
+		case bcd::TraceOp::Compare: g_sink += (opr.isInteger ? opr.arg1.compare( opr.integer) : opr.arg1.compare( opr.arg2)) + 1; break;
+		case bcd::TraceOp::Root: g_sink += opr.arg1.iroot( (unsigned int)opr.integer).first.nof_digits(); break;
+		case bcd::TraceOp::Save: bcd::saveNumber( NullDevice, opr.arg1); break;
+		case bcd::TraceOp::Write: bcd::writeNumber( g_nullFile, opr.arg1); break;
+	}
+}
+
+struct OperationTotals
+{
+	std::size_t count;
+	std::size_t failures;
+	std::size_t elements;
+	double ns;
+};
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		std::size_t repeat = 1;
+		bool failOnErrors = false;
+		std::string traceFile;
+
+		int argi = 1;
+		for (; argi < argc; ++argi)
+		{
+			std::string opt = argv[ argi];
+			if (opt == "-h")
+			{
+				usage();
+				return 0;
+			}
+			else if (opt == "-r")
+			{
+				if (argi+1 == argc) throw std::runtime_error( "missing argument of option " + opt);
+				repeat = std::strtoul( argv[ ++argi], nullptr, 10);
+			}
+			else if (opt == "-f")
+			{
+				failOnErrors = true;
+			}
+			else if (opt[0] == '-' || !traceFile.empty())
+			{
+				usage();
+				throw std::runtime_error( "unexpected argument " + opt);
+			}
+			else
+			{
+				traceFile = opt;
+			}
+		}
+		if (traceFile.empty())
+		{
+			usage();
+			throw std::runtime_error( "missing trace file argument");
+		}
+		std::vector<Operation> operations;
+		bool withValues;
+		{
+			bcd::TraceReader reader( traceFile);
+			withValues = reader.withValues();
+			bcd::TraceRecord rec;
+			while (reader.next( rec)) operations.push_back( createOperation( rec));
+		}
+		std::fprintf( stderr, "%zu operations read from %s (%s)\n", operations.size(), traceFile.c_str(), withValues ? "values" : "sizes and hashes");
+
+		g_nullFile = std::fopen( NullDevice, "wb");
+		if (!g_nullFile) throw std::runtime_error( "failed to open " NullDevice);
+
+		typedef std::chrono::steady_clock Clock;
+		std::vector<OperationTotals> totals( bcd::NofTraceOps, OperationTotals{0,0,0,0.0});
+		Clock::time_point start = Clock::now();
+		for (std::size_t ri = 0; ri < repeat; ++ri)
+		{
+			for (const Operation& opr : operations)
+			{
+				OperationTotals& tt = totals[ (std::size_t)opr.op];
+				Clock::time_point opstart = Clock::now();
+				try
+				{
+					execute( opr);
+				}
+				catch (const std::runtime_error&)
+				{
+					// ... operations failing like a division by zero fail in the replay too
+					++tt.failures;
+				}
+				tt.ns += std::chrono::duration<double,std::nano>( Clock::now() - opstart).count();
+				tt.elements += std::max( opr.arg1.nof_elements(), opr.arg2.nof_elements());
+				++tt.count;
+			}
+		}
+		double elapsed = std::chrono::duration<double>( Clock::now() - start).count();
+
+		std::size_t nofOperations = 0;
+		std::size_t nofFailures = 0;
+		std::printf( "%-10s %12s %10s %14s %12s\n", "operation", "count", "failures", "ns/op", "elements/op");
+		for (std::size_t oi = 0; oi < bcd::NofTraceOps; ++oi)
+		{
+			const OperationTotals& tt = totals[ oi];
+			if (!tt.count) continue;
+			nofOperations += tt.count;
+			nofFailures += tt.failures;
+			std::printf( "%-10s %12zu %10zu %14.1f %12.1f\n", bcd::traceOpName( (bcd::TraceOp)oi), tt.count, tt.failures, tt.ns / tt.count, (double)tt.elements / tt.count);
+		}
+		std::printf( "%zu operations in %.3f s, %.0f ops/s\n", nofOperations, elapsed, elapsed > 0.0 ? nofOperations / elapsed : 0.0);
+		std::fclose( g_nullFile);
+		if (failOnErrors && nofFailures)
+		{
+			std::cerr << "ERROR " << nofFailures << " operations failed in the replay" << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << "ERROR " << err.what() << std::endl;
+		return 2;
+	}
+}
+
@@ -5,15 +5,16 @@ local args = lapp( [[
 Test program for Lua bcd module
 	-h,--help     Print usage
 	-V,--verbose  Verbose output
+	-T,--trace    (optional string)  Keep the trace of the trace test in this file
 ]])
 if args.help then
-	print( "Usage: testBcdArithmetics.lua [-h][-V]")
+	print( "Usage: testBcdArithmetics.lua [-h][-V][-T <tracefile>]")
 	exit( 0)
 end
 local verbose = args.verbose
 
 function checkResult( testname, output, expected)
-	if not output == expected then
+	if tostring( output) ~= tostring( expected) then
 		io.stderr:write( "OUPUT:  " .. tostring(output) .. "\n")
 		io.stderr:write( "EXPECT: " .. tostring(expected) .. "\n")
 		error( "Test " .. testname .. " failed")
@@ -85,6 +86,74 @@ function test_pow( arg1, arg2, expect)
 	checkResult( "mod", result, expect)
 end
 
+function test_isqrt( arg, expect, expect_remainder)
+	local result,rm = bcd.int( arg):isqrt()
+	if verbose then
+		print( "Test " .. arg .. ":isqrt()\n = " .. tostring(result) .. ", " ..  tostring(rm))
+	end
+	checkResult( "isqrt result", result, expect)
+	checkResult( "isqrt remainder", rm, expect_remainder)
+end
+
+function test_iroot( arg1, arg2, expect, expect_remainder)
+	local result,rm = bcd.int( arg1):iroot( arg2)
+	if verbose then
+		print( "Test " .. arg1 .. ":iroot( " .. arg2 .. ")\n = " .. tostring(result) .. ", " ..  tostring(rm))
+	end
+	checkResult( "iroot result", result, expect)
+	checkResult( "iroot remainder", rm, expect_remainder)
+end
+
+function test_factorial( arg, expect)
+	local result = bcd.factorial( arg)
+	if verbose then
+		print( "Test bcd.factorial( " .. arg .. ")\n = " .. tostring(result))
+	end
+	checkResult( "factorial", result, expect)
+end
+
+function test_binomial( arg1, arg2, expect)
+	local result = bcd.binomial( arg1, arg2)
+	if verbose then
+		print( "Test bcd.binomial( " .. arg1 .. ", " .. arg2 .. ")\n = " .. tostring(result))
+	end
+	checkResult( "binomial", result, expect)
+end
+
+function test_product( list, expect)
+	local result = bcd.product( list)
+	if verbose then
+		print( "Test bcd.product( {" .. table.concat( list, ", ") .. "})\n = " .. tostring(result))
+	end
+	checkResult( "product", result, expect)
+end
+
+function test_sum( list, expect)
+	local result = bcd.sum( list)
+	if verbose then
+		print( "Test bcd.sum( {" .. table.concat( list, ", ") .. "})\n = " .. tostring(result))
+	end
+	checkResult( "sum", result, expect)
+end
+
+function test_dot( list1, list2, expect)
+	local result = bcd.dot( list1, list2)
+	if verbose then
+		print( "Test bcd.dot( {" .. table.concat( list1, ", ") .. "}, {" .. table.concat( list2, ", ") .. "})\n = " .. tostring(result))
+	end
+	checkResult( "dot", result, expect)
+end
+
+function test_vector( name, result, expect)
+	local values = {}
+	for ii,vv in ipairs( result:totable()) do values[ ii] = tostring( vv) end
+	local output = table.concat( values, ", ")
+	if verbose then
+		print( "Test bcd.vector " .. name .. "\n = {" .. output .. "}")
+	end
+	checkResult( "vector " .. name, output, table.concat( expect, ", "))
+end
+
 local bits64 = bcd.bits(64)
 
 function test_bitwise_and( arg1, arg2, expect)
@@ -132,9 +201,35 @@ test_div2( "987634312046372657243165894732984627528652743256289", "4892346897432
 test_mul( "0928371943675932874568502547967845730265254230214350790843750295746572438246723875240396738754528068705942",
 		"39487234590423085763409320895769851928347032465784012647436754821376",
 		"36658840727098609307697432257185681689428878561927181333141886403981219498661407725702082804606976599086870750054575860734996213845434704579807433483080295407315953679816192")
+bcd.set_threads( 4, 10)
+test_mul( "0928371943675932874568502547967845730265254230214350790843750295746572438246723875240396738754528068705942",
+		"39487234590423085763409320895769851928347032465784012647436754821376",
+		"36658840727098609307697432257185681689428878561927181333141886403981219498661407725702082804606976599086870750054575860734996213845434704579807433483080295407315953679816192")
+bcd.set_threads( 1)
 test_mod( "30942103589712319893284128990876865428891253462134879327434651029345238746374832478534895727852664945893",
 		"1209487632765213498032",
 		"809309430900907004341")
+test_add( "987634312046372657243165894732984627528652743256289", 0, "987634312046372657243165894732984627528652743256289" )
+test_sub( "987634312046372657243165894732984627528652743256289", 1000000007, "987634312046372657243165894732984627528651743256282" )
+test_mul( "987634312046372657243165894732984627528652743256289", -123456789,
+		"-121930160871469187360638853558046294501048473178462843996021" )
+test_div2( "987634312046372657243165894732984627528652743256289", 97, "10181797031405903682919236028175099252872708693363", "78" )
+test_mod( "987634312046372657243165894732984627528652743256289", 1000000007, "382237051" )
+test_div2( "-999999999999999999", "-123456789", "8100000073", "87654402" )
+test_mod( "-999999999999999999", "1000000007", "48" )
+-- Regression tests of bugs found by tests/fuzzBcd.cpp:
+-- ... negative divisor larger than the dividend
+test_div2( "12", "-123456789012345678901234567890", "0", "12" )
+test_div2( "-12", "-123456789012345678901234567890", "0", "12" )
+-- ... carry of the ten's complement with zero low elements of a negative difference
+test_sub( "0", "200000000000000000000000000000000000000", "-200000000000000000000000000000000000000" )
+test_sub( "100000000000000000000000000000000000000000000", "100000000000000000000000000000000000000000001", "-1" )
+-- ... copies of an empty number
+test_add( "0", 0, "0" )
+test_unm( "0", "0" )
+checkResult( "copy zero", bcd.int( bcd.int( 0)), "0")
+test_mul( "999999999", "1000000007", "1000000005999999993" )
+test_mul( "999999999999999999", "999999999999999999", "999999999999999998000000000000000001" )
 test_pow( "3", "3", "27" )
 test_pow( "3432", "324",
 		"32909285492191702601486641617030895261336571028125928148482029183417" ..
@@ -154,6 +249,33 @@ test_pow( "3432", "324",
 		"36466383463798658047987437720922762342224029720601714890158421689199" ..
 		"33691116060472959502025027634958237190003423128920297045827782588699" ..
 		"3090255435128824256023942282058827464021476042241921253376" )
+test_isqrt( "2", "1", "1" )
+test_isqrt( "98347520394875203948572039485720394857203948570239485702394857",
+		"9917031833914581316476831989880", "6512043265881659506565279980457")
+test_iroot( "27", 3, "3", "0" )
+test_iroot( "98347520394875203948572039485720394857203948570239485702394857", 7,
+		"717974565", "93659433827417068579255979744509155869063157794816732")
+test_factorial( 30, "265252859812191058636308480000000" )
+checkResult( "factorial of non integer", pcall( bcd.factorial, 5.5), false)
+checkResult( "binomial of non integer", pcall( bcd.binomial, 10.5, 3), false)
+checkResult( "factorial of integral float", bcd.factorial( 5.0), "120")
+test_binomial( 100, 37, "3420029547493938143902737600" )
+test_binomial( 3000000000, 2, "4499999998500000000" )
+test_binomial( 1000000000000, 3, "166666666666166666666667000000000000" )
+test_binomial( 100000, 20, "4102514927544637253661023897279339467698676089637590646460244715070212997318745000" )
+test_product( {"-12345678901234567890", 987, -3, "1000000000000000000001"},
+		"36555555226555555522326555555226555555522290" )
+test_sum( {"999999999999999999999999999999", 1, "-12345678901234567890", 77}, "999999999987654321098765432187" )
+test_dot( {"1000000000000000000000", -2, 3}, {"123456789", "55555555555555555555", 7}, "123456788888888888888888888911" )
+
+local vec1 = bcd.vector( {"123456789012345678901234567890", -5, 0, "-999999999999999999"}, 40)
+local vec2 = bcd.vector( {1, "876543210987654321098765432110", 7, "-1"}, 40)
+test_vector( "add", vec1 + vec2, {"123456789012345678901234567891", "876543210987654321098765432105", "7", "-1000000000000000000"} )
+test_vector( "sub", vec1 - vec2, {"123456789012345678901234567889", "-876543210987654321098765432115", "-7", "-999999999999999998"} )
+test_vector( "mul", vec1 * vec2, {"123456789012345678901234567890", "-4382716054938271605493827160550", "0", "999999999999999999"} )
+test_vector( "scalar mul", vec1 * 3, {"370370367037037036703703703670", "-15", "0", "-2999999999999999997"} )
+test_vector( "scalar sub", 10 - vec1, {"-123456789012345678901234567880", "15", "10", "1000000000000000009"} )
+checkResult( "vector compare", table.concat( vec1:compare( vec2), ", "), "1, -1, -1, -1")
 
 test_bitwise_and( "3", "1", "1" )
 test_bitwise_and( "29341730247", "918273", "393473" )
@@ -161,8 +283,118 @@ test_bitwise_or( "434254654", "983476324", "1006549886" )
 test_bitwise_xor( "434254654", "983476324", "595368794" )
 test_bitwise_not( "434254654", bcd.int( "434254654"):bit_xor( bcd.int(2) ^ 64 - 1, bits64) )
 
+local acc = bcd.int( 0)
+for ii = 1, 100 do
+	acc = acc + "1000000000000000000000" - "1"
+	if ii % 10 == 0 then collectgarbage() end
+end
+checkResult( "cached string operand", tostring(acc), "99999999999999999999900")
+if verbose then print( "Test cached string operand = " .. tostring(acc)) end
+
+local fac = bcd.int( 1)
+for ii = 2, 30 do
+	fac = fac * ii
+end
+fac = (fac * fac - fac) % "1000000000000000000000000000000000007"
+checkResult( "inline result elements", tostring(fac), "655853830658792059030587068695272540")
+if verbose then print( "Test inline result elements = " .. tostring(fac)) end
+
+local huge = bcd.factorial( 2000)
+local inuse = bcd.memory()
+huge:free()
+checkResult( "free", tostring(huge), "0")
+checkResult( "memory", inuse > bcd.memory(), true)
+if verbose then print( "Test free, memory in use " .. inuse .. " -> " .. bcd.memory()) end
+
+local shared = bcd.factorial( 1000)
+local sharedcopy = bcd.int( shared)
+local sharedneg = -shared
+shared:free()
+checkResult( "shared copy", tostring(sharedcopy), tostring(bcd.factorial( 1000)))
+checkResult( "shared negation", tostring(-sharedneg), tostring(sharedcopy))
+if verbose then print( "Test shared copy of 1000!") end
+
 checkResult( "BCD from float", tostring(bcd.int(7.23)), "7")
 if verbose then print( "Test BCD from float 7.23 = 7") end
 
+local tracefile = args.trace or os.tmpname()
+local tracedfile = os.tmpname()
+bcd.trace_start( tracefile)
+local traced = (bcd.int( "123456789012345678901234567890") * 7 + "1") / 3
+traced:save( tracedfile)
+local tracedfh = io.open( tracedfile, "w")
+traced:write( tracedfh)
+tracedfh:close()
+bcd.trace_stop()
+os.remove( tracedfile)
+local tracefh = io.open( tracefile, "rb")
+local traceheader = tracefh:read( 8)
+tracefh:close()
+if not args.trace then os.remove( tracefile) end
+checkResult( "trace", traceheader, "BCDTRACE")
+if verbose then print( "Test trace of " .. tostring(traced)) end
+
+local ea, eb, ec, ed, ee, em = bcd.expr( 6)
+local expr = (ea * eb + ec * ed - ee) % em
+local exprargs = {"123456789012345678901234567890", "-98765432109876543210", "55555555555555555555555", 77, "-1", "1000000000000000000000000000057"}
+local direct = (bcd.int( exprargs[1]) * exprargs[2] + bcd.int( exprargs[3]) * exprargs[4] - exprargs[5]) % exprargs[6]
+checkResult( "expression", tostring(expr:eval( table.unpack( exprargs))), tostring(direct))
+if verbose then print( "Test expression " .. tostring(expr) .. " = " .. tostring(direct)) end
+
+local ex = bcd.expr( 1)
+local exsquare = ex * ex
+local expoly = exsquare * exsquare - 3 * exsquare + ex - "1000000000000000000000" + -ex / 7
+local exresults = expoly:map( {2, bcd.int( "-12345678901234567890"), "99999999999999999999"})
+local expected = {}
+for ii,val in ipairs( {2, "-12345678901234567890", "99999999999999999999"}) do
+	exresults[ ii] = tostring( exresults[ ii])
+	local xx = bcd.int( val)
+	local quot = (-xx) / 7
+	expected[ #expected+1] = tostring( xx^4 - xx^2 * 3 + xx - "1000000000000000000000" + quot)
+end
+checkResult( "expression map", table.concat( exresults, ", "), table.concat( expected, ", "))
+if verbose then print( "Test expression map " .. tostring(expoly)) end
+local badvec = bcd.vector( {1}, 1)
+checkResult( "expression bad argument", pcall( expoly.eval, expoly, badvec), false)
+checkResult( "expression map bad argument", pcall( expoly.map, expoly, {1, badvec}), false)
+checkResult( "expression bad operand", pcall( function() return ex + badvec end), false)
+
+local numberfile = os.tmpname()
+local savednum = -bcd.factorial( 20000)
+savednum:save( numberfile)
+local loadednum = bcd.load( numberfile)
+local numberfh = io.open( numberfile, "wb")
+bcd.int( "98765432109876543210"):write( numberfh)
+numberfh:write( "\n")
+numberfh:close()
+checkResult( "save and load", loadednum == savednum, true)
+checkResult( "write and load", tostring(bcd.load( numberfile)), "98765432109876543210")
+os.remove( numberfile)
+if verbose then print( "Test save and load of " .. #tostring(savednum) .. " digits") end
+
+local packednum = bcd.factorial( 300) * -7
+local packed = packednum:pack()
+checkResult( "pack size", #packed, 16 + 8 * 42)
+checkResult( "unpack", tostring(bcd.unpack( packed)), tostring(packednum))
+checkResult( "unpack zero", tostring(bcd.unpack( bcd.int( 0):pack())), "0")
+local function patchBytes( str, pos, bytes)
+	return str:sub( 1, pos-1) .. bytes .. str:sub( pos + #bytes)
+end
+local packed12 = bcd.int( 12):pack()
+local corruptPacked = {
+	["magic"] = patchBytes( packed12, 1, "XY"),
+	["version"] = patchBytes( packed12, 3, string.char( 2)),
+	["flags"] = patchBytes( packed12, 4, string.char( 2)),
+	["digit"] = patchBytes( packed12, 17, string.char( 0x1A)),
+	["truncated"] = packed12:sub( 1, #packed12 - 1),
+	["size"] = patchBytes( packed12, 9, string.char( 2)),
+	["zero top element"] = patchBytes( packed12, 17, string.rep( string.char( 0), 8)),
+	["negative zero"] = patchBytes( bcd.int( 0):pack(), 4, string.char( 1))
+}
+for name,str in pairs( corruptPacked) do
+	checkResult( "unpack corrupt " .. name, pcall( bcd.unpack, str), false)
+end
+if verbose then print( "Test pack and unpack of " .. #packed .. " bytes") end
+
 print( "OK")
 